@@ -21,6 +21,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 *********************************************************************/
 
 #include "crosshair.h"
+#include "crosshair_texture_cache.h"
 
 #include <kwinconfig.h>
 #include <kwinglutils.h>
@@ -37,7 +38,14 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <kdebug.h>
 
+#include <QDateTime>
+#include <QDBusConnection>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTimer>
+#include <QVector2D>
 #include <QVector4D>
+#include <qnumeric.h>
 
 namespace KWin
 {
@@ -45,9 +53,48 @@ namespace KWin
 KWIN_EFFECT(crosshair, CrosshairEffect)
 KWIN_EFFECT_SUPPORTED(crosshair, CrosshairEffect::supported())
 
+// Nudges closer together than this are treated as key repeat (ms)
+static const int NUDGE_REPEAT_INTERVAL = 150;
+// Number of repeated nudges before the step grows by another NudgeStep
+static const int NUDGE_REPEATS_PER_STEP = 4;
+// Delay before a changed offset is saved when AutoSaveOffset is on (ms)
+static const int OFFSET_SAVE_DELAY = 2000;
+// Feed positions further off-screen than this are rejected (pixels)
+static const float FEED_MAX_COORDINATE = 1000000.0f;
+// Marks core quads for the outline shader, must match CORE_PASS in crosshair_outline.frag
+static const float OUTLINE_CORE_PASS = 4.0f;
+
 CrosshairEffect::CrosshairEffect()
-    : texture(NULL)
+    : enabled(false)
+    , outlineShader(NULL)
+    , nudgeRepeat(0)
+    , lastNudgeX(0)
+    , lastNudgeY(0)
+    , texture(NULL)
+    , alphaTexture(0)
+    , tintShader(NULL)
+    , textureBytes(0)
+    , resourcesReady(false)
+    , magnifierTexture(NULL)
+    , magnifierShader(NULL)
+    , feed(NULL)
+    , feedPosition(false)
+    , feedColor(false)
+    , adaptiveColor(false)
+    , adaptiveOnBright(false)
+    , adaptiveCollecting(false)
+    , adaptiveNext(0)
+    , adaptiveTexture(NULL)
+    , adaptiveTarget(NULL)
 {
+    for (int i = 0; i < ADAPTIVE_BUFFERS; ++i) {
+        readbacks[i].pbo = 0;
+#ifndef KWIN_HAVE_OPENGLES
+        readbacks[i].fence = 0;
+#endif
+        readbacks[i].pending = false;
+    }
+
     KActionCollection* actionCollection = new KActionCollection(this);
     KAction* a;
 
@@ -76,6 +123,16 @@ CrosshairEffect::CrosshairEffect()
     a->setGlobalShortcut(KShortcut());
     connect(a, SIGNAL(triggered(bool)), this, SLOT(moveRight()));
 
+    a = static_cast<KAction*>(actionCollection->addAction("PulseCrosshair"));
+    a->setText(i18n("Pulse Crosshair"));
+    a->setGlobalShortcut(KShortcut());
+    connect(a, SIGNAL(triggered(bool)), this, SLOT(pulse()));
+
+    a = static_cast<KAction*>(actionCollection->addAction("RecoilCrosshair"));
+    a->setText(i18n("Recoil Crosshair"));
+    a->setGlobalShortcut(KShortcut());
+    connect(a, SIGNAL(triggered(bool)), this, SLOT(recoil()));
+
     a = static_cast<KAction*>(actionCollection->addAction("ResetCrosshairOffset"));
     a->setText(i18n("Reset Crosshair Offset"));
     a->setGlobalShortcut(KShortcut());
@@ -91,28 +148,51 @@ CrosshairEffect::CrosshairEffect()
     connect(effects, SIGNAL(windowGeometryShapeChanged(KWin::EffectWindow*, QRect)), this, SLOT(slotWindowGeometryShapeChanged(KWin::EffectWindow*, QRect)));
     connect(effects, SIGNAL(windowFinishUserMovedResized(KWin::EffectWindow*)), this, SLOT(slotWindowFinishUserMovedResized(KWin::EffectWindow*)));
 
+    QDBusConnection::sessionBus().registerObject("/Crosshair", this, QDBusConnection::ExportScriptableContents);
+
+    releaseTimer = new QTimer(this);
+    releaseTimer->setSingleShot(true);
+    connect(releaseTimer, SIGNAL(timeout()), this, SLOT(slotReleaseTimeout()));
+
+    saveTimer = new QTimer(this);
+    saveTimer->setSingleShot(true);
+    connect(saveTimer, SIGNAL(timeout()), this, SLOT(saveOffset()));
+
     reconfigure(ReconfigureAll);
 }
 
 CrosshairEffect::~CrosshairEffect()
 {
-    if (texture != NULL) {
-        delete texture;
+    // Don't lose nudges still waiting to be saved
+    if (saveTimer->isActive()) {
+        saveOffset();
     }
+    QDBusConnection::sessionBus().unregisterObject("/Crosshair");
+    releaseResources();
 }
 
 void CrosshairEffect::reconfigure(ReconfigureFlags)
 {
+    // The offset is read back below, save any nudges that are still pending
+    if (saveTimer->isActive()) {
+        saveOffset();
+    }
+
     KConfigGroup conf = EffectsHandler::effectConfig("Crosshair");
 
     size  = conf.readEntry("Size", 20);
     width = conf.readEntry("LineWidth", 1) / 2.0f;
+    outlineWidth = qMax(0, conf.readEntry("OutlineWidth", 0));
+    outlineColor = conf.readEntry("OutlineColor", QColor(0, 0, 0));
 
     color = conf.readEntry("Color", QColor(255, 48, 48));
     alpha = conf.readEntry("Alpha", 100) / 100.0f;
     color.setAlphaF(alpha);
+    outlineColor.setAlphaF(alpha);
+    currentColor = color;
 
     shape    = static_cast<Shape>    (conf.readEntry("Shape",    static_cast<int>(IMAGE)));
+    configShape = shape;
     blend    = static_cast<BlendMode>(conf.readEntry("Blend",    static_cast<int>(INVERT_WITH_ALPHA)));
     position = static_cast<Position> (conf.readEntry("Position", static_cast<int>(SCREEN_CENTRE)));
 
@@ -120,54 +200,347 @@ void CrosshairEffect::reconfigure(ReconfigureFlags)
 
     offsetX = conf.readEntry("OffsetX", 0);
     offsetY = conf.readEntry("OffsetY", 0);
+    pendingOffsetX = 0;
+    pendingOffsetY = 0;
+
+    nudgeStep      = qMax(1, conf.readEntry("NudgeStep", 1));
+    nudgeMaxStep   = conf.readEntry("NudgeMaxStep", 1);
+    autoSaveOffset = conf.readEntry("AutoSaveOffset", false);
 
     imagePath = conf.readEntry("Image", KGlobal::dirs()->findResource("data", "kwin/crosshair_glow.png"));
 
+    adaptiveColor = conf.readEntry("AdaptiveColor", false);
+#ifdef KWIN_HAVE_OPENGLES
+    adaptiveColor = false; // No pixel buffer objects in OpenGL ES 2.0
+#else
+    if (adaptiveColor && !hasGLVersion(2, 1) && !hasGLExtension("GL_ARB_pixel_buffer_object")) {
+        kDebug() << "Pixel buffer objects not supported, adaptive colour disabled";
+        adaptiveColor = false;
+    }
+    // Without fences there is no way to tell whether mapping a buffer would block
+    if (adaptiveColor && !hasGLVersion(3, 2) && !hasGLExtension("GL_ARB_sync")) {
+        kDebug() << "Sync objects not supported, adaptive colour disabled";
+        adaptiveColor = false;
+    }
+#endif
+    adaptiveOnBright = false;
+    adaptiveCollecting = false;
+    if (adaptiveColor) {
+        currentColor = contrastingColor(adaptiveOnBright);
+    }
+
+    magnifier        = conf.readEntry("Magnifier", false);
+    magnifierSize    = qMax(1, conf.readEntry("MagnifierSize", 100));
+    magnifierZoom    = qMax(100, conf.readEntry("MagnifierZoom", 200)) / 100.0f;
+    magnifierShape   = static_cast<MagnifierShape>(conf.readEntry("MagnifierShape", static_cast<int>(MAGNIFIER_CIRCLE)));
+    magnifierSmooth  = conf.readEntry("MagnifierSmooth", true);
+    magnifierRect    = QRect();
+
+    releaseDelay = conf.readEntry("ReleaseDelay", 0);
+
+    trace.setEnabled(conf.readEntry("Trace", false));
+
+    animation.setFade(conf.readEntry("FadeDuration", 0));
+    animation.setPulse(conf.readEntry("PulseDuration", 300), conf.readEntry("PulseScale", 50) / 100.0f);
+    animation.setRecoil(conf.readEntry("RecoilDuration", 200), conf.readEntry("RecoilSpread", 10));
+    // The crosshair is hidden below, a fade starts from transparent
+    animation.reset();
+
+    feedPosition = false;
+    feedColor = false;
+    if (conf.readEntry("Feed", false)) {
+        if (feed == NULL) {
+            feed = new CrosshairFeed(this);
+            connect(feed, SIGNAL(updated()), this, SLOT(slotFeedUpdated()));
+            connect(feed, SIGNAL(clientsChanged()), this, SLOT(slotFeedClientsChanged()));
+        }
+        if (!feed->start()) {
+            delete feed;
+            feed = NULL;
+        }
+    } else {
+        delete feed;
+        feed = NULL;
+    }
+
+    updateScreenCentres();
+
     enabled = false;
+    if (feed != NULL) {
+        feed->setActive(false);
+    }
 
-    if (texture != NULL) {
-        delete texture;
-        texture = NULL;
+    // Images and GL objects are only created once the crosshair is shown
+    releaseResources();
+
+    if ((effects->compositingType() & OpenGLCompositing) == 0) {
+        kDebug() << "Unsupported compositing type (not OpenGL)!";
+    }
+}
+
+static const int CACHE_MAX_ENTRIES = 8;
+
+bool CrosshairEffect::loadTexture()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QFile file(imagePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        kDebug() << "Cannot open crosshair image" << imagePath;
+        return false;
+    }
+
+    const QByteArray data = file.readAll();
+    const QString cachePath = KStandardDirs::locateLocal("cache", "kwin-crosshair/"
+                              + CrosshairTextureCache::key(data, 2 * size));
+
+    bool result = false;
+    {
+        CrosshairTextureCache cache(cachePath);
+        // The image refers to the mapping directly, uploading copies it
+        const QImage image = cache.load(2 * size);
+        if (!image.isNull()) {
+            result = uploadTexture(image);
+        }
+    }
+
+    if (result) {
+        kDebug() << "Crosshair texture loaded from cache in" << timer.elapsed() << "ms";
+        return true;
+    }
+
+    const QImage image = CrosshairTextureCache::decode(data, 2 * size);
+    if (image.isNull()) {
+        kDebug() << "Cannot decode crosshair image" << imagePath;
+        return false;
     }
 
-    if (shape == 0 && !imagePath.isEmpty()) {
-        QImage image(imagePath);
+    result = uploadTexture(image);
+    kDebug() << "Crosshair texture decoded in" << timer.elapsed() << "ms";
+
+    CrosshairTextureCache cache(cachePath);
+    if (!cache.store(image)) {
+        kDebug() << "Cannot write crosshair texture cache" << cachePath;
+    }
+    cache.expire(CACHE_MAX_ENTRIES);
+
+    return result;
+}
+
+/* Images which are white apart from their alpha channel (the usual case,
+ * since they are tinted with Color anyway) only need one byte per texel. */
+static bool isAlphaOnly(const QImage& image)
+{
+    for (int y = 0; y < image.height(); ++y) {
+        const QRgb* line = reinterpret_cast<const QRgb*>(image.constScanLine(y));
+        for (int x = 0; x < image.width(); ++x) {
+            // Premultiplied, so white texels have all components equal
+            const int a = qAlpha(line[x]);
+            if (qAbs(qRed(line[x]) - a) > 2 || qAbs(qGreen(line[x]) - a) > 2 || qAbs(qBlue(line[x]) - a) > 2) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static bool isPowerOfTwo(int n)
+{
+    return n > 0 && (n & (n - 1)) == 0;
+}
+
+bool CrosshairEffect::uploadTexture(const QImage& image)
+{
+    const bool powerOfTwo = isPowerOfTwo(image.width()) && isPowerOfTwo(image.height());
+#ifdef KWIN_HAVE_OPENGLES
+    // ES 2.0 takes any size, but only mipmaps powers of two
+    const bool npot = true;
+    const bool mipmaps = powerOfTwo || hasGLExtension("GL_OES_texture_npot");
+#else
+    const bool npot = hasGLVersion(2, 0) || hasGLExtension("GL_ARB_texture_non_power_of_two");
+    // KWin resolves glGenerateMipmap to the EXT variant where needed
+    const bool mipmaps = (powerOfTwo || npot)
+                         && (hasGLVersion(3, 0) || hasGLExtension("GL_ARB_framebuffer_object")
+                             || hasGLExtension("GL_EXT_framebuffer_object"));
+#endif
+
+    // Without NPOT textures GLTexture below takes care of the size
+    if ((powerOfTwo || npot) && isAlphaOnly(image)) {
+        tintShader = ShaderManager::instance()->loadFragmentShader(ShaderManager::SimpleShader,
+                KGlobal::dirs()->findResource("data", "kwin/crosshair_tint.frag"));
+        if (!tintShader->isValid()) {
+            kDebug() << "Tint shader failed to load, uploading the full image";
+            delete tintShader;
+            tintShader = NULL;
+        }
+    }
+
+    if (tintShader == NULL) {
         texture = new GLTexture(image);
+        textureBytes = texture->width() * texture->height() * 4;
+        kDebug() << "Crosshair texture is RGBA," << textureBytes << "bytes";
+        return true;
     }
 
-    switch (position) {
-        case SCREEN_CENTRE:
-            currentPosition = getScreenCentre();
-            break;
+    QByteArray alpha(image.width() * image.height(), 0);
+    uchar* out = reinterpret_cast<uchar*>(alpha.data());
+    for (int y = 0; y < image.height(); ++y) {
+        const QRgb* line = reinterpret_cast<const QRgb*>(image.constScanLine(y));
+        for (int x = 0; x < image.width(); ++x) {
+            *out++ = qAlpha(line[x]);
+        }
+    }
 
-        case WINDOW_CENTRE:
-            break;
+    glGenTextures(1, &alphaTexture);
+    glBindTexture(GL_TEXTURE_2D, alphaTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA, image.width(), image.height(), 0,
+                 GL_ALPHA, GL_UNSIGNED_BYTE, alpha.constData());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    // The image is already scaled to the rendered size, so the base level
+    // is drawn 1:1 and the smaller levels serve any scaled-down drawing.
+    // Where they can't be generated, GL_LINEAR keeps the texture complete.
+    if (mipmaps) {
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    } else {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
 
-        case CURRENT_WINDOW_CENTRE:
-            currentPosition = getWindowCentre(effects->activeWindow());
-            break;
+    // A full mipmap chain adds about a third
+    textureBytes = alpha.size() * (mipmaps ? 4 : 3) / 3;
+    kDebug() << "Crosshair texture is alpha only," << textureBytes << "bytes";
+    return true;
+}
+
+void CrosshairEffect::drawAlphaTexture(const QRegion& region)
+{
+    ShaderManager *shaderManager = ShaderManager::instance();
+    shaderManager->pushShader(tintShader);
+    tintShader->setUniform("tint", QVector4D(
+                               currentColor.redF(),
+                               currentColor.greenF(),
+                               currentColor.blueF(),
+                               alpha * animation.opacity()));
+
+    glBindTexture(GL_TEXTURE_2D, alphaTexture);
+
+    GLVertexBuffer *vbo = GLVertexBuffer::streamingBuffer();
+    for (int i = 0; i < crosshairRects.size(); ++i) {
+        const QRect& rect = crosshairRects[i];
+        if (!region.intersects(rect)) {
+            continue;
+        }
+
+        const float l = rect.left(), r = rect.x() + rect.width();
+        const float t = rect.top(),  b = rect.y() + rect.height();
+        const float verts[] = {
+            l, t,  r, t,  r, b,
+            r, b,  l, b,  l, t
+        };
+        // The first uploaded row is the top of the image
+        const float texcoords[] = {
+            0, 0,  1, 0,  1, 1,
+            1, 1,  0, 1,  0, 0
+        };
+
+        vbo->reset();
+        vbo->setData(6, 2, verts, texcoords);
+        vbo->render(GL_TRIANGLES);
     }
 
-    createCrosshair(currentPosition, verts);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    shaderManager->popShader();
+}
 
-    if ((effects->compositingType() & OpenGLCompositing) == 0) {
-        kDebug() << "Unsupported compositing type (not OpenGL)!";
+int CrosshairEffect::textureMemory() const
+{
+    return textureBytes;
+}
+
+qlonglong CrosshairEffect::feedPickupTime(uint sequence) const
+{
+    // Sequence numbers wrap around
+    if (feed == NULL || static_cast<qint32>(feed->lastSequence() - sequence) < 0) {
+        return -1;
+    }
+    return feed->lastReadTime();
+}
+
+void CrosshairEffect::prePaintScreen(ScreenPrePaintData& data, int time)
+{
+    CrosshairTraceScope scope(trace, "prePaintScreen");
+
+    // Always the latest value, however many the client wrote since
+    CrosshairFeedSlot update;
+    if (enabled && feed != NULL && feed->read(update)) {
+        applyFeedUpdate(update);
+        data.paint |= crosshairRegion();
+    }
+
+    if (pendingOffsetX != 0 || pendingOffsetY != 0) {
+        applyPendingOffset();
+        data.paint |= crosshairRegion();
+    }
+
+    if (enabled && adaptiveColor) {
+        collectBackground();
+
+        // The whole area has to be repainted to be read back
+        if (data.paint.intersects(currentPositionRect)) {
+            data.paint |= currentPositionRect;
+        }
+    }
+
+    if (enabled) {
+        // The area painted before the animation moved on is damaged too
+        const QRegion damage = animation.isAnimating() ? crosshairRegion() : QRegion();
+        const CrosshairAnimation::Frame frame = animation.prePaint(time);
+        if (frame != CrosshairAnimation::Unchanged) {
+            applyAnimationFrame(frame);
+            data.paint |= damage | crosshairRegion();
+        }
+    }
+
+    // The inset shows what's under it, so any change inside redraws all of it
+    if (enabled && magnifier && data.paint.intersects(magnifierRect)) {
+        data.paint |= magnifierRect;
     }
+
+    effects->prePaintScreen(data, time);
 }
 
 void CrosshairEffect::paintScreen(int mask, QRegion region, ScreenPaintData& data)
 {
+    CrosshairTraceScope scope(trace, "paintScreen");
+
     effects->paintScreen(mask, region, data);   // paint normal screen
 
-    if (!enabled)
+    if (!enabled || !region.intersects(crosshairRegion()))
         return;
 
+    // Sample the background before the crosshair is drawn over it. Frames
+    // repainted only to collect the results don't start new readbacks,
+    // otherwise the effect would never stop repainting.
+    if (adaptiveColor && !adaptiveCollecting && region.intersects(currentPositionRect)) {
+        readBackground();
+    }
+
     if (effects->compositingType() & OpenGLCompositing) {
 #ifndef KWIN_HAVE_OPENGLES
         glEnable(GL_LINE_SMOOTH);
 #endif
         glPushAttrib(GL_CURRENT_BIT | GL_ENABLE_BIT);
 
+        if (magnifier && region.intersects(magnifierRect)) {
+            drawMagnifier();
+        }
+
         switch (blend) {
             case NONE:
                 break;
@@ -225,15 +598,50 @@ void CrosshairEffect::paintScreen(int mask, QRegion region, ScreenPaintData& dat
         glLineWidth(width);
 
         ShaderManager *shaderManager = ShaderManager::instance();
-        if (shape != IMAGE) {
+        if (shape != IMAGE && outlineWidth > 0 && outlineShader != NULL) {
+            // Stroke and outline in a single draw per crosshair
+            shaderManager->pushShader(outlineShader);
+            outlineShader->setUniform("lineColor", QVector4D(
+                                          currentColor.redF(),
+                                          currentColor.greenF(),
+                                          currentColor.blueF(),
+                                          currentColor.alphaF() * animation.opacity()));
+            outlineShader->setUniform("outlineColor", QVector4D(
+                                          outlineColor.redF(),
+                                          outlineColor.greenF(),
+                                          outlineColor.blueF(),
+                                          outlineColor.alphaF() * animation.opacity()));
+            outlineShader->setUniform("coreWidth", lineHalfWidth() / (lineHalfWidth() + outlineWidth));
+
+            GLVertexBuffer *vbo = GLVertexBuffer::streamingBuffer();
+            for (int i = 0; i < outlineVerts.size(); ++i) {
+                if (!region.intersects(crosshairRects[i])) {
+                    continue;
+                }
+                vbo->reset();
+                vbo->setData(outlineVerts[i].size() / 2, 2, outlineVerts[i].data(), outlineTexCoords[i].data());
+                vbo->render(GL_TRIANGLES);
+            }
+
+            shaderManager->popShader();
+        } else if (shape != IMAGE) {
             shaderManager->pushShader(ShaderManager::ColorShader);
 
+            QColor fadedColor = currentColor;
+            fadedColor.setAlphaF(currentColor.alphaF() * animation.opacity());
+
             GLVertexBuffer *vbo = GLVertexBuffer::streamingBuffer();
-            vbo->reset();
-            vbo->setUseColor(true);
-            vbo->setColor(color);
-            vbo->setData(verts.size() / 2, 2, verts.data(), NULL);
-            vbo->render(GL_LINES);
+            for (int i = 0; i < crosshairVerts.size(); ++i) {
+                // Outputs not being repainted are left alone
+                if (!region.intersects(crosshairRects[i])) {
+                    continue;
+                }
+                vbo->reset();
+                vbo->setUseColor(true);
+                vbo->setColor(fadedColor);
+                vbo->setData(crosshairVerts[i].size() / 2, 2, crosshairVerts[i].data(), NULL);
+                vbo->render(GL_LINES);
+            }
 
             shaderManager->popShader();
         } else if (texture != NULL) {
@@ -242,16 +650,22 @@ void CrosshairEffect::paintScreen(int mask, QRegion region, ScreenPaintData& dat
             GLShader *shader = shaderManager->getBoundShader();
             shader->setUniform(GLShader::Saturation, 1.0);
             shader->setUniform(GLShader::ModulationConstant, QVector4D(
-                                   color.redF(),
-                                   color.greenF(),
-                                   color.blueF(),
-                                   alpha));
+                                   currentColor.redF(),
+                                   currentColor.greenF(),
+                                   currentColor.blueF(),
+                                   alpha * animation.opacity()));
 
             texture->bind();
-            texture->render(region, currentPositionRect);
+            for (int i = 0; i < crosshairRects.size(); ++i) {
+                if (region.intersects(crosshairRects[i])) {
+                    texture->render(region, crosshairRects[i]);
+                }
+            }
             texture->unbind();
 
             shaderManager->popShader();
+        } else if (alphaTexture != 0) {
+            drawAlphaTexture(region);
         }
 
         glLineWidth(1.0f);
@@ -262,32 +676,610 @@ void CrosshairEffect::paintScreen(int mask, QRegion region, ScreenPaintData& dat
     }
 }
 
+void CrosshairEffect::postPaintScreen()
+{
+    adaptiveCollecting = false;
+
+    if (enabled && adaptiveColor) {
+        for (int i = 0; i < ADAPTIVE_BUFFERS; ++i) {
+            if (readbacks[i].pending) {
+                // Make sure there is a frame to pick up the result in
+                requestRepaint(currentPositionRect);
+                adaptiveCollecting = true;
+                break;
+            }
+        }
+    }
+
+    // Only the animated area, and only until the animations are done
+    if (enabled && animation.needsRepaint()) {
+        requestRepaint(crosshairRegion());
+    }
+
+    effects->postPaintScreen();
+}
+
+void CrosshairEffect::applyAnimationFrame(CrosshairAnimation::Frame frame)
+{
+    if (frame == CrosshairAnimation::FadedOut) {
+        // The caller already damages the last painted area
+        enabled = false;
+        if (feed != NULL) {
+            feed->setActive(false);
+        }
+        if (releaseDelay > 0) {
+            releaseTimer->start(releaseDelay * 1000);
+        }
+    }
+
+    if (enabled) {
+        createCrosshairs();
+    }
+}
+
+void CrosshairEffect::pulse()
+{
+    if (enabled && animation.pulse()) {
+        requestRepaint(crosshairRegion());
+    }
+}
+
+void CrosshairEffect::recoil()
+{
+    if (enabled && animation.recoil()) {
+        requestRepaint(crosshairRegion());
+    }
+}
+
+void CrosshairEffect::readBackground()
+{
+#ifndef KWIN_HAVE_OPENGLES
+    Readback& rb = readbacks[adaptiveNext];
+    if (rb.pending) {
+        // All buffers are still in flight, skip this frame rather than wait
+        return;
+    }
+
+    const QRect screen(0, 0, displayWidth(), displayHeight());
+    QRect source = currentPositionRect & screen;
+    if (source.isEmpty()) {
+        return;
+    }
+
+    if (rb.pbo == 0) {
+        glGenBuffers(1, &rb.pbo);
+    }
+
+    if (GLRenderTarget::blitSupported()) {
+        // Let the GPU downsample the area, only a few texels are read back
+        if (adaptiveTarget == NULL) {
+            adaptiveTexture = new GLTexture(ADAPTIVE_SAMPLES, ADAPTIVE_SAMPLES);
+            adaptiveTarget = new GLRenderTarget(adaptiveTexture);
+        }
+        rb.size = QSize(ADAPTIVE_SAMPLES, ADAPTIVE_SAMPLES);
+        adaptiveTarget->blitFromFramebuffer(source, QRect(QPoint(0, 0), rb.size), GL_LINEAR);
+        GLRenderTarget::pushRenderTarget(adaptiveTarget);
+        source = QRect(0, 0, rb.size.width(), rb.size.height());
+    } else {
+        // Without blitting, sample only the centre of the area
+        source = QRect(0, 0, qMin(source.width(), 2 * ADAPTIVE_SAMPLES),
+                             qMin(source.height(), 2 * ADAPTIVE_SAMPLES));
+        source.moveCenter(currentPositionRect.center());
+        source &= screen;
+        rb.size = source.size();
+        source.moveTop(displayHeight() - source.y() - source.height());
+    }
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, rb.pbo);
+    glBufferData(GL_PIXEL_PACK_BUFFER, rb.size.width() * rb.size.height() * 4, NULL, GL_STREAM_READ);
+    glReadPixels(source.x(), source.y(), source.width(), source.height(), GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    if (GLRenderTarget::blitSupported()) {
+        GLRenderTarget::popRenderTarget();
+    }
+
+    rb.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    rb.pending = true;
+
+    adaptiveNext = (adaptiveNext + 1) % ADAPTIVE_BUFFERS;
+#endif
+}
+
+void CrosshairEffect::collectBackground()
+{
+#ifndef KWIN_HAVE_OPENGLES
+    // Use the newest finished readback, never wait for one
+    int newest = -1;
+    for (int n = 1; n <= ADAPTIVE_BUFFERS; ++n) {
+        const int i = (adaptiveNext - n + ADAPTIVE_BUFFERS) % ADAPTIVE_BUFFERS;
+        Readback& rb = readbacks[i];
+        if (!rb.pending) {
+            continue;
+        }
+
+        // A zero timeout only polls, mapping a signalled buffer never blocks
+        const GLenum status = glClientWaitSync(rb.fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+            continue;
+        }
+
+        if (newest == -1) {
+            newest = i;
+        }
+        // Older results are superseded
+        glDeleteSync(rb.fence);
+        rb.fence = 0;
+        rb.pending = (i == newest);
+    }
+
+    if (newest == -1) {
+        return;
+    }
+
+    Readback& rb = readbacks[newest];
+    rb.pending = false;
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, rb.pbo);
+    const uchar* pixels = static_cast<const uchar*>(glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY));
+    if (pixels != NULL) {
+        const int count = rb.size.width() * rb.size.height();
+        float sum = 0.0f;
+        for (int i = 0; i < count; ++i, pixels += 4) {
+            sum += 0.2126f * pixels[0] + 0.7152f * pixels[1] + 0.0722f * pixels[2];
+        }
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+
+        if (count > 0) {
+            updateAdaptiveColor(sum / (count * 255.0f));
+        }
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+#endif
+}
+
+void CrosshairEffect::updateAdaptiveColor(float luminance)
+{
+    // Hysteresis, so the colour doesn't flicker on mid-grey backgrounds
+    bool onBright = adaptiveOnBright;
+    if (luminance > 0.6f) {
+        onBright = true;
+    } else if (luminance < 0.4f) {
+        onBright = false;
+    }
+
+    if (onBright == adaptiveOnBright || feedColor) {
+        return;
+    }
+    adaptiveOnBright = onBright;
+
+    currentColor = contrastingColor(onBright);
+    requestRepaint(crosshairRegion());
+}
+
+QColor CrosshairEffect::contrastingColor(bool onBright) const
+{
+    // Keep the hue, but make it dark on bright backgrounds and vice versa
+    return QColor::fromHsvF(color.hsvHueF(),
+                            color.hsvSaturationF(),
+                            onBright ? 0.2 : 1.0,
+                            alpha);
+}
+
+void CrosshairEffect::releaseAdaptiveBuffers()
+{
+#ifndef KWIN_HAVE_OPENGLES
+    for (int i = 0; i < ADAPTIVE_BUFFERS; ++i) {
+        Readback& rb = readbacks[i];
+        if (rb.pending && rb.fence != 0) {
+            glDeleteSync(rb.fence);
+        }
+        if (rb.pbo != 0) {
+            glDeleteBuffers(1, &rb.pbo);
+        }
+        rb.pbo = 0;
+        rb.fence = 0;
+        rb.pending = false;
+    }
+#endif
+    adaptiveNext = 0;
+
+    delete adaptiveTarget;
+    adaptiveTarget = NULL;
+    delete adaptiveTexture;
+    adaptiveTexture = NULL;
+}
+
+void CrosshairEffect::ensureResources()
+{
+    if (resourcesReady) {
+        return;
+    }
+
+    if (configShape == IMAGE && !imagePath.isEmpty()) {
+        loadTexture();
+    }
+
+    if (outlineWidth > 0) {
+        outlineShader = ShaderManager::instance()->loadFragmentShader(ShaderManager::SimpleShader,
+                KGlobal::dirs()->findResource("data", "kwin/crosshair_outline.frag"));
+        if (!outlineShader->isValid()) {
+            kDebug() << "Outline shader failed to load, drawing without outline";
+            delete outlineShader;
+            outlineShader = NULL;
+        }
+    }
+
+    if (magnifier) {
+        magnifierShader = ShaderManager::instance()->loadFragmentShader(ShaderManager::SimpleShader,
+                KGlobal::dirs()->findResource("data", "kwin/crosshair_magnifier.frag"));
+        if (!magnifierShader->isValid()) {
+            kDebug() << "Magnifier shader failed to load, using a square inset";
+            delete magnifierShader;
+            magnifierShader = NULL;
+        }
+    }
+
+    resourcesReady = true;
+}
+
+void CrosshairEffect::releaseResources()
+{
+    releaseTimer->stop();
+
+    if (texture != NULL) {
+        delete texture;
+        texture = NULL;
+    }
+    if (alphaTexture != 0) {
+        glDeleteTextures(1, &alphaTexture);
+        alphaTexture = 0;
+    }
+    delete tintShader;
+    tintShader = NULL;
+    textureBytes = 0;
+    releaseAdaptiveBuffers();
+
+    delete magnifierTexture;
+    magnifierTexture = NULL;
+    delete magnifierShader;
+    magnifierShader = NULL;
+    delete outlineShader;
+    outlineShader = NULL;
+
+    resourcesReady = false;
+}
+
+void CrosshairEffect::slotReleaseTimeout()
+{
+    if (!enabled) {
+        releaseResources();
+    }
+}
+
+void CrosshairEffect::requestRepaint(const QRegion& region)
+{
+    trace.instant("addRepaint");
+    effects->addRepaint(region);
+}
+
+QString CrosshairEffect::dumpTrace()
+{
+    if (!trace.isEnabled()) {
+        return QString();
+    }
+
+    const QString fileName = KStandardDirs::locateLocal("tmp",
+            QString("kwin-crosshair-trace-%1.json").arg(QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss")));
+    if (!trace.dump(fileName)) {
+        kDebug() << "Cannot write crosshair trace" << fileName;
+        return QString();
+    }
+    return fileName;
+}
+
 void CrosshairEffect::toggle()
 {
-    enabled = !enabled;
+    if (!animation.hasFade()) {
+        setVisible(!enabled);
+        return;
+    }
+
+    if (!enabled) {
+        setVisible(true);
+        animation.fadeIn();
+    } else {
+        animation.reverseFade();
+    }
+    requestRepaint(crosshairRegion());
+}
+
+void CrosshairEffect::setVisible(bool enable)
+{
+    // Damage where the crosshair was, and below where it will be
+    QRegion damage = crosshairRegion();
+
+    enabled = enable;
+    if (feed != NULL) {
+        feed->setActive(enabled);
+    }
     if (enabled) {
-        switch (position) {
-            case SCREEN_CENTRE:
-                currentPosition = getScreenCentre();
-                break;
+        releaseTimer->stop();
+        ensureResources();
 
-            case WINDOW_CENTRE:
-                currentPosition = getWindowCentre(effects->activeWindow());
-                lastWindow = effects->activeWindow();
-                break;
+        if (!feedPosition) {
+            updatePosition();
+        }
+        createCrosshairs();
+        damage |= crosshairRegion();
+    } else if (releaseDelay > 0) {
+        releaseTimer->start(releaseDelay * 1000);
+    }
+    requestRepaint(damage);
+}
 
-            case CURRENT_WINDOW_CENTRE:
-                currentPosition = getWindowCentre(effects->activeWindow());
-                lastWindow = effects->activeWindow();
-                break;
+void CrosshairEffect::updatePosition()
+{
+    switch (position) {
+        case SCREEN_CENTRE:
+        case ALL_SCREEN_CENTRES:
+            currentPosition = getScreenCentre();
+            break;
+
+        case WINDOW_CENTRE:
+            currentPosition = getWindowCentre(effects->activeWindow());
+            lastWindow = effects->activeWindow();
+            break;
+
+        case CURRENT_WINDOW_CENTRE:
+            currentPosition = getWindowCentre(effects->activeWindow());
+            lastWindow = effects->activeWindow();
+            break;
+    }
+}
+
+void CrosshairEffect::applyFeedUpdate(const CrosshairFeedSlot& update)
+{
+    // One crosshair per output ignores the position. Clients can write
+    // anything, positions that can't be rounded to pixels are dropped.
+    if ((update.flags & CROSSHAIR_FEED_POSITION) && position != ALL_SCREEN_CENTRES
+            && qIsFinite(update.x) && qIsFinite(update.y)
+            && qAbs(update.x) <= FEED_MAX_COORDINATE && qAbs(update.y) <= FEED_MAX_COORDINATE) {
+        currentPosition = QPointF(update.x, update.y);
+        feedPosition = true;
+    }
+
+    if (update.flags & CROSSHAIR_FEED_SHAPE) {
+        // The image is only loaded if it's configured
+        if ((update.shape > IMAGE && update.shape <= DIAMOND)
+                || (update.shape == IMAGE && (texture != NULL || alphaTexture != 0))) {
+            shape = static_cast<Shape>(update.shape);
+        }
+    }
+
+    if (update.flags & CROSSHAIR_FEED_COLOR) {
+        currentColor = QColor::fromRgba(update.color);
+        feedColor = true;
+    }
+
+    createCrosshairs();
+}
+
+void CrosshairEffect::slotFeedUpdated()
+{
+    // Damage the old area, the new one is added in prePaintScreen
+    if (enabled) {
+        requestRepaint(crosshairRegion());
+    }
+}
+
+void CrosshairEffect::slotFeedClientsChanged()
+{
+    if (feed->hasClients() || (!feedPosition && !feedColor && shape == configShape)) {
+        return;
+    }
+
+    // The last client is gone, go back to the configured crosshair
+    QRegion damage = crosshairRegion();
+
+    shape = configShape;
+    if (feedColor) {
+        currentColor = adaptiveColor ? contrastingColor(adaptiveOnBright) : color;
+    }
+    feedPosition = false;
+    feedColor = false;
+
+    if (enabled) {
+        updatePosition();
+        createCrosshairs();
+        requestRepaint(damage | crosshairRegion());
+    }
+}
+
+void CrosshairEffect::createCrosshairs()
+{
+    if (position != ALL_SCREEN_CENTRES) {
+        crosshairVerts.resize(1);
+        crosshairRects.resize(1);
+        createCrosshair(currentPosition, crosshairVerts[0]);
+        crosshairRects[0] = currentPositionRect;
+    } else {
+        const int count = screenCentres.size();
+        crosshairVerts.resize(count);
+        crosshairRects.resize(count);
+        for (int i = 0; i < count; ++i) {
+            createCrosshair(screenCentres[i], crosshairVerts[i]);
+            crosshairRects[i] = currentPositionRect;
+        }
+
+        // The active output's crosshair is the one sampled for adaptive colour
+        const int active = qBound(0, effects->activeScreen(), count - 1);
+        if (count > 0) {
+            currentPosition = screenCentres[active];
+            currentPositionRect = crosshairRects[active];
+        }
+    }
+
+    if (outlineWidth > 0 && shape != IMAGE) {
+        outlineVerts.resize(crosshairVerts.size());
+        outlineTexCoords.resize(crosshairVerts.size());
+        for (int i = 0; i < crosshairVerts.size(); ++i) {
+            createOutline(crosshairVerts[i], outlineVerts[i], outlineTexCoords[i]);
+        }
+    }
+
+    updateMagnifierRect();
+}
+
+/* Turns the line pairs of a crosshair into triangles for the outline shader.
+ * All outline quads come first and all core quads after them, so one draw
+ * call paints the cores over the outlines of crossing lines. Core quads get
+ * OUTLINE_CORE_PASS added to their x texture coordinate; the shader uses it
+ * to tell them apart and discards the core area of the outline quads. */
+void CrosshairEffect::createOutline(const QVector<float>& lines, QVector<float>& v, QVector<float>& tc)
+{
+    const float core = lineHalfWidth();
+    const float total = core + outlineWidth;
+
+    v.clear();
+    tc.clear();
+    for (int pass = 0; pass < 2; ++pass) {
+        const bool outlinePass = (pass == 0);
+        const float half = outlinePass ? total : core;
+
+        for (int i = 0; i + 3 < lines.size(); i += 4) {
+            const float x1 = lines[i],     y1 = lines[i + 1];
+            const float x2 = lines[i + 2], y2 = lines[i + 3];
+            const float length = sqrtf((x2 - x1) * (x2 - x1) + (y2 - y1) * (y2 - y1));
+            if (length <= 0.0f) {
+                continue;
+            }
+
+            // Unit vectors along and across the line
+            const float dx = (x2 - x1) / length, dy = (y2 - y1) / length;
+            const float nx = -dy, ny = dx;
+
+            // The outline also extends past both ends
+            const float ext   = outlinePass ? outlineWidth : 0.0f;
+            const float start = -ext / length;
+            const float end   = 1.0f + ext / length;
+            const float ax = x1 - dx * ext, ay = y1 - dy * ext;
+            const float bx = x2 + dx * ext, by = y2 + dy * ext;
+            const float across = half / total;
+            const float shift  = outlinePass ? 0.0f : OUTLINE_CORE_PASS;
+
+            v  << ax + nx * half << ay + ny * half
+               << bx + nx * half << by + ny * half
+               << bx - nx * half << by - ny * half
+               << bx - nx * half << by - ny * half
+               << ax - nx * half << ay - ny * half
+               << ax + nx * half << ay + ny * half;
+            tc << shift + across << start << shift + across << end   << shift - across << end
+               << shift - across << end   << shift - across << start << shift + across << start;
+        }
+    }
+}
+
+float CrosshairEffect::lineHalfWidth() const
+{
+    // Matches the thickness of the glLineWidth(width) lines
+    return qMax(1.0f, width) / 2.0f;
+}
+
+void CrosshairEffect::updateMagnifierRect()
+{
+    if (!magnifier) {
+        return;
+    }
+
+    magnifierRect = QRect(0, 0, 2 * magnifierSize, 2 * magnifierSize);
+    magnifierRect.moveCenter(currentPositionRect.center());
+}
+
+void CrosshairEffect::drawMagnifier()
+{
+    // Only the area shown in the inset is copied, so the cost depends on
+    // the inset size and zoom, not on the output resolution
+    const int sourceSize = qMax(1, qRound(magnifierRect.width() / magnifierZoom));
+    QRect source(0, 0, sourceSize, sourceSize);
+    source.moveCenter(magnifierRect.center());
+
+    // Keep the source on screen, near edges the inset is slightly off-centre
+    const QRect screen(0, 0, displayWidth(), displayHeight());
+    source.moveLeft(qBound(0, source.x(), qMax(0, screen.width()  - source.width())));
+    source.moveTop (qBound(0, source.y(), qMax(0, screen.height() - source.height())));
+    source &= screen;
+    if (source.isEmpty()) {
+        return;
+    }
+
+    if (magnifierTexture == NULL || magnifierTexture->size() != source.size()) {
+        delete magnifierTexture;
+        magnifierTexture = new GLTexture(source.width(), source.height());
+    }
+
+    magnifierTexture->bind();
+    magnifierTexture->setFilter(magnifierSmooth ? GL_LINEAR : GL_NEAREST);
+    glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0,
+                        source.x(), displayHeight() - source.y() - source.height(),
+                        source.width(), source.height());
+
+    // Framebuffer rows are bottom-up
+    const float l = magnifierRect.left(), r = magnifierRect.x() + magnifierRect.width();
+    const float t = magnifierRect.top(),  b = magnifierRect.y() + magnifierRect.height();
+    const float s = source.width()  / float(magnifierTexture->width());
+    const float u = source.height() / float(magnifierTexture->height());
+    const float verts[] = {
+        l, t,  r, t,  r, b,
+        r, b,  l, b,  l, t
+    };
+    const float texcoords[] = {
+        0, u,  s, u,  s, 0,
+        s, 0,  0, 0,  0, u
+    };
+
+    ShaderManager *shaderManager = ShaderManager::instance();
+    const bool round = (magnifierShape == MAGNIFIER_CIRCLE && magnifierShader != NULL);
+    if (round) {
+        shaderManager->pushShader(magnifierShader);
+        magnifierShader->setUniform("center", QVector2D(s / 2.0f, u / 2.0f));
+        magnifierShader->setUniform("radius", s / 2.0f);
+    } else {
+        shaderManager->pushShader(ShaderManager::SimpleShader);
+        GLShader *shader = shaderManager->getBoundShader();
+        shader->setUniform(GLShader::Saturation, 1.0);
+        shader->setUniform(GLShader::ModulationConstant, QVector4D(1.0, 1.0, 1.0, 1.0));
+    }
+
+    glDisable(GL_BLEND);
+
+    GLVertexBuffer *vbo = GLVertexBuffer::streamingBuffer();
+    vbo->reset();
+    vbo->setData(6, 2, verts, texcoords);
+    vbo->render(GL_TRIANGLES);
+
+    magnifierTexture->unbind();
+    shaderManager->popShader();
+}
+
+QRegion CrosshairEffect::crosshairRegion() const
+{
+    QRegion region;
+    if (enabled) {
+        for (int i = 0; i < crosshairRects.size(); ++i) {
+            region |= crosshairRects[i];
+        }
+        if (magnifier) {
+            region |= magnifierRect;
         }
-        createCrosshair(currentPosition, verts);
     }
-    effects->addRepaintFull();
+    return region;
 }
 
 void CrosshairEffect::createCrosshair(QPointF &pos, QVector<float> &v)
 {
+    CrosshairTraceScope scope(trace, "createCrosshair");
+
     float x = pos.x() + offsetX;
     float y = pos.y() + offsetY;
 
@@ -296,7 +1288,14 @@ void CrosshairEffect::createCrosshair(QPointF &pos, QVector<float> &v)
         y = round(y);
     }
 
-    currentPositionRect = QRect(x - size, y - size, 2 * size, 2 * size);
+    // Pulse and recoil animations scale the whole crosshair
+    const float size = this->size * animation.scale() + animation.spread();
+
+    currentPositionRect = QRect(qRound(x - size), qRound(y - size), qRound(2 * size), qRound(2 * size));
+    if (outlineWidth > 0 && shape != IMAGE) {
+        const int margin = outlineWidth + ceilf(lineHalfWidth());
+        currentPositionRect.adjust(-margin, -margin, margin, margin);
+    }
 
     v.clear();
     switch (shape) {
@@ -374,9 +1373,22 @@ bool CrosshairEffect::isActive() const
 
 QPointF CrosshairEffect::getScreenCentre()
 {
-    const QRect& rect = effects->clientArea(ScreenArea, effects->activeScreen(), 0);
-    return QPointF(rect.x() + rect.width () / 2.0f,
-                   rect.y() + rect.height() / 2.0f);
+    const int screen = effects->activeScreen();
+    if (screen >= 0 && screen < screenCentres.size()) {
+        return screenCentres[screen];
+    }
+    return QPointF(0, 0);
+}
+
+void CrosshairEffect::updateScreenCentres()
+{
+    const int count = effects->numScreens();
+    screenCentres.resize(count);
+    for (int i = 0; i < count; ++i) {
+        const QRect& rect = effects->clientArea(ScreenArea, i, 0);
+        screenCentres[i] = QPointF(rect.x() + rect.width () / 2.0f,
+                                   rect.y() + rect.height() / 2.0f);
+    }
 }
 
 QPointF CrosshairEffect::getWindowCentre(KWin::EffectWindow* w)
@@ -393,12 +1405,12 @@ QPointF CrosshairEffect::getWindowCentre(KWin::EffectWindow* w)
 
 bool CrosshairEffect::isEnabledForScreen()
 {
-    return enabled && (position == SCREEN_CENTRE);
+    return enabled && !feedPosition && (position == SCREEN_CENTRE || position == ALL_SCREEN_CENTRES);
 }
 
 bool CrosshairEffect::isEnabledForWindow(KWin::EffectWindow* w)
 {
-    return enabled
+    return enabled && !feedPosition
         // Check if always enabled for current window
         && (position == CURRENT_WINDOW_CENTRE
             // Otherwise check if it's the window set by user
@@ -407,37 +1419,50 @@ bool CrosshairEffect::isEnabledForWindow(KWin::EffectWindow* w)
 
 void CrosshairEffect::slotScreenGeometryChanged(const QSize& size)
 {
+    trace.instant("screenGeometryChanged");
+
     Q_UNUSED(size);
 
+    // Output centres are only ever queried here
+    updateScreenCentres();
+
     if (isEnabledForScreen()) {
+        QRegion damage = crosshairRegion();
         currentPosition = getScreenCentre();
-        createCrosshair(currentPosition, verts);
+        createCrosshairs();
+        requestRepaint(damage | crosshairRegion());
     }
 }
 
 void CrosshairEffect::slotWindowActivated(KWin::EffectWindow* w)
 {
+    trace.instant("windowActivated");
+
     if (isEnabledForWindow(w)) {
         currentPosition = getWindowCentre(w);
-        createCrosshair(currentPosition, verts);
+        createCrosshairs();
     }
 }
 
 void CrosshairEffect::slotWindowGeometryShapeChanged(KWin::EffectWindow* w, const QRect& old)
 {
+    trace.instant("windowGeometryShapeChanged");
+
     Q_UNUSED(old);
 
     if (isEnabledForWindow(w)) {
         currentPosition = getWindowCentre(effects->activeWindow());
-        createCrosshair(currentPosition, verts);
+        createCrosshairs();
     }
 }
 
 void CrosshairEffect::slotWindowFinishUserMovedResized(KWin::EffectWindow* w)
 {
+    trace.instant("windowFinishUserMovedResized");
+
     if (isEnabledForWindow(w)) {
         currentPosition = getWindowCentre(effects->activeWindow());
-        createCrosshair(currentPosition, verts);
+        createCrosshairs();
     }
 }
 
@@ -448,46 +1473,94 @@ bool CrosshairEffect::supported()
 
 void CrosshairEffect::updateOffset()
 {
-    createCrosshair(currentPosition, verts);
-    effects->addRepaintFull();
+    QRegion damage = crosshairRegion();
+    createCrosshairs();
+    requestRepaint(damage | crosshairRegion());
+}
+
+void CrosshairEffect::nudge(int dx, int dy)
+{
+    // Key repeat in the same direction speeds the crosshair up
+    if (nudgeTimer.isValid() && nudgeTimer.elapsed() < NUDGE_REPEAT_INTERVAL
+            && dx == lastNudgeX && dy == lastNudgeY) {
+        ++nudgeRepeat;
+    } else {
+        nudgeRepeat = 0;
+    }
+    nudgeTimer.start();
+    lastNudgeX = dx;
+    lastNudgeY = dy;
+
+    const int step = qMin(nudgeStep * (1 + nudgeRepeat / NUDGE_REPEATS_PER_STEP),
+                          qMax(nudgeStep, nudgeMaxStep));
+
+    // Applied once per frame in prePaintScreen, however many nudges arrive
+    pendingOffsetX += dx * step;
+    pendingOffsetY += dy * step;
+
+    if (enabled) {
+        requestRepaint(crosshairRegion());
+    } else {
+        applyPendingOffset();
+    }
+}
+
+void CrosshairEffect::applyPendingOffset()
+{
+    offsetX += pendingOffsetX;
+    offsetY += pendingOffsetY;
+    pendingOffsetX = 0;
+    pendingOffsetY = 0;
+
+    if (enabled) {
+        createCrosshairs();
+    }
+
+    if (autoSaveOffset) {
+        saveTimer->start(OFFSET_SAVE_DELAY);
+    }
 }
 
 void CrosshairEffect::moveUp()
 {
-    offsetY -= 1;
-    updateOffset();
+    nudge(0, -1);
 }
 
 void CrosshairEffect::moveDown()
 {
-    offsetY += 1;
-    updateOffset();
+    nudge(0, 1);
 }
 
 void CrosshairEffect::moveLeft()
 {
-    offsetX -= 1;
-    updateOffset();
+    nudge(-1, 0);
 }
 
 void CrosshairEffect::moveRight()
 {
-    offsetX += 1;
-    updateOffset();
+    nudge(1, 0);
 }
 
 void CrosshairEffect::resetOffset()
 {
     offsetX = 0;
     offsetY = 0;
+    pendingOffsetX = 0;
+    pendingOffsetY = 0;
     updateOffset();
+
+    if (autoSaveOffset) {
+        saveTimer->start(OFFSET_SAVE_DELAY);
+    }
 }
 
 void CrosshairEffect::saveOffset()
 {
+    saveTimer->stop();
+
     KConfigGroup conf = EffectsHandler::effectConfig("Crosshair");
-    conf.writeEntry("OffsetX", offsetX);
-    conf.writeEntry("OffsetY", offsetY);
+    conf.writeEntry("OffsetX", offsetX + pendingOffsetX);
+    conf.writeEntry("OffsetY", offsetY + pendingOffsetY);
     conf.sync();
 }
 
@@ -25,6 +25,14 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <kwineffects.h>
 #include <kwinglutils.h>
 
+#include <QElapsedTimer>
+
+#include "crosshair_animation.h"
+#include "crosshair_feed.h"
+#include "crosshair_trace.h"
+
+class QTimer;
+
 namespace KWin
 {
 
@@ -32,20 +40,39 @@ class CrosshairEffect
     : public Effect
 {
     Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.kde.kwin.Crosshair")
 
 public:
 
     CrosshairEffect();
     ~CrosshairEffect();
     virtual void reconfigure(ReconfigureFlags);
+    virtual void prePaintScreen(ScreenPrePaintData& data, int time);
     virtual void paintScreen(int mask, QRegion region, ScreenPaintData& data);
+    virtual void postPaintScreen();
     virtual bool isActive() const;
 
     static bool supported();
 
+public slots:
+
+    /* Writes the recorded trace to a temporary file and returns its name,
+     * or an empty string when tracing is off (Trace=true in the config). */
+    Q_SCRIPTABLE QString dumpTrace();
+
+    /* Bytes of texture memory used by the loaded crosshair image */
+    Q_SCRIPTABLE int textureMemory() const;
+
+    /* CLOCK_MONOTONIC time in nanoseconds at which the external control
+     * update with the given sequence number, or a newer one, was picked up
+     * for painting; -1 if it hasn't been yet */
+    Q_SCRIPTABLE qlonglong feedPickupTime(uint sequence) const;
+
 private slots:
 
     void toggle();
+    void pulse();
+    void recoil();
 
     void moveUp();
     void moveDown();
@@ -59,13 +86,19 @@ private slots:
     void slotWindowGeometryShapeChanged(KWin::EffectWindow* w, const QRect& old);
     void slotWindowFinishUserMovedResized(KWin::EffectWindow* w);
 
+    void slotReleaseTimeout();
+
+    void slotFeedUpdated();
+    void slotFeedClientsChanged();
+
 private:
 
     enum Position
     {
         SCREEN_CENTRE         = 0,
         WINDOW_CENTRE         = 1, /* Single window only */
-        CURRENT_WINDOW_CENTRE = 2  /* Always follow window focus */
+        CURRENT_WINDOW_CENTRE = 2, /* Always follow window focus */
+        ALL_SCREEN_CENTRES    = 3  /* One crosshair per output */
     };
 
     enum Shape
@@ -93,33 +126,131 @@ private:
         MULTIPLY           = 9
     };
 
+    enum MagnifierShape
+    {
+        MAGNIFIER_CIRCLE = 0,
+        MAGNIFIER_SQUARE = 1
+    };
+
     void createCrosshair(QPointF &pos, QVector<float> &v);
+    void createCrosshairs();
+    void setVisible(bool enable);
+    void applyAnimationFrame(CrosshairAnimation::Frame frame);
+    void createOutline(const QVector<float>& lines, QVector<float>& v, QVector<float>& tc);
+    float lineHalfWidth() const;
+    void updatePosition();
+    void applyFeedUpdate(const CrosshairFeedSlot& update);
+    void updateMagnifierRect();
+    void drawMagnifier();
+    QRegion crosshairRegion() const;
+    bool loadTexture();
+    bool uploadTexture(const QImage& image);
+    void drawAlphaTexture(const QRegion& region);
+    void ensureResources();
+    void releaseResources();
 
     QPointF getScreenCentre();
+    void updateScreenCentres();
     QPointF getWindowCentre(KWin::EffectWindow* w);
 
     bool isEnabledForScreen();
     bool isEnabledForWindow(KWin::EffectWindow* w);
 
     void updateOffset();
+    void requestRepaint(const QRegion& region);
+    void nudge(int dx, int dy);
+    void applyPendingOffset();
 
-    QVector<float> verts;
+    void readBackground();
+    void collectBackground();
+    void updateAdaptiveColor(float luminance);
+    QColor contrastingColor(bool onBright) const;
+    void releaseAdaptiveBuffers();
+
+    QVector< QVector<float> > crosshairVerts; /* One entry per crosshair */
+    QVector<QRect> crosshairRects;
+    QVector<QPointF> screenCentres;
     bool enabled;
     int size;
     float width;
+    int outlineWidth; /* 0 = no outline */
+    QColor outlineColor;
+    GLShader* outlineShader;
+    QVector< QVector<float> > outlineVerts;
+    QVector< QVector<float> > outlineTexCoords;
     float alpha;
     QColor color;
+    QColor currentColor; /* Color, or its adaptive replacement */
     Shape shape;
+    Shape configShape; /* Shape, unless overridden by the feed */
     BlendMode blend;
     Position position;
     bool roundPosition;
     int offsetX;
     int offsetY;
+    int pendingOffsetX;
+    int pendingOffsetY;
+    int nudgeStep;
+    int nudgeMaxStep;
+    int nudgeRepeat;
+    int lastNudgeX;
+    int lastNudgeY;
+    QElapsedTimer nudgeTimer;
+    bool autoSaveOffset;
+    QTimer* saveTimer;
     QString imagePath;
     GLTexture* texture;
+    GLuint alphaTexture; /* Used instead of texture for alpha-only images */
+    GLShader* tintShader;
+    int textureBytes;
+    bool resourcesReady;
+    int releaseDelay;  /* Seconds disabled before freeing resources, 0 = never */
+    QTimer* releaseTimer;
     QPointF currentPosition;
     QRect currentPositionRect;
     KWin::EffectWindow *lastWindow;
+
+    /* Magnified inset around the crosshair */
+    bool magnifier;
+    int magnifierSize;  /* Radius of the inset */
+    float magnifierZoom;
+    MagnifierShape magnifierShape;
+    bool magnifierSmooth;
+    QRect magnifierRect;
+    GLTexture* magnifierTexture;
+    GLShader* magnifierShader;
+
+    /* Position, shape and colour written by external applications */
+    CrosshairFeed* feed;
+    bool feedPosition;
+    bool feedColor;
+
+    CrosshairAnimation animation;
+
+    CrosshairTrace trace;
+
+    /* Adaptive colour: the background under the crosshair is read back
+     * asynchronously through a ring of pixel buffer objects, so its
+     * luminance is known one or two frames late without stalling the GPU. */
+    enum { ADAPTIVE_BUFFERS = 3, ADAPTIVE_SAMPLES = 16 };
+
+    struct Readback
+    {
+        GLuint pbo;
+#ifndef KWIN_HAVE_OPENGLES
+        GLsync fence;
+#endif
+        QSize size;
+        bool pending;
+    };
+
+    bool adaptiveColor;
+    bool adaptiveOnBright;
+    bool adaptiveCollecting;
+    int adaptiveNext;
+    Readback readbacks[ADAPTIVE_BUFFERS];
+    GLTexture* adaptiveTexture;
+    GLRenderTarget* adaptiveTarget;
 };
 
 } // namespace
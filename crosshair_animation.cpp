@@ -0,0 +1,167 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2013 Pawel Bartkiewicz <tuuresairon@gmail.com>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+
+#include "crosshair_animation.h"
+
+#include <QEasingCurve>
+
+namespace KWin
+{
+
+CrosshairAnimation::CrosshairAnimation()
+    : m_fadeDuration(0)
+    , m_pulseDuration(0)
+    , m_pulseScale(0.0f)
+    , m_recoilDuration(0)
+    , m_recoilSpread(0)
+    , m_fadeRunning(false)
+    , m_fadingOut(false)
+    , m_pulseRunning(false)
+    , m_recoilRunning(false)
+{
+    m_fadeTimeline.setEasingCurve(QEasingCurve::InOutQuad);
+    m_pulseTimeline.setEasingCurve(QEasingCurve::SineCurve);
+    m_recoilTimeline.setEasingCurve(QEasingCurve::OutCubic);
+}
+
+void CrosshairAnimation::setFade(int duration)
+{
+    m_fadeDuration = qMax(0, duration);
+    m_fadeTimeline.setDuration(qMax(1, m_fadeDuration));
+}
+
+void CrosshairAnimation::setPulse(int duration, float scale)
+{
+    m_pulseDuration = qMax(0, duration);
+    m_pulseScale = scale;
+    m_pulseTimeline.setDuration(qMax(1, m_pulseDuration));
+}
+
+void CrosshairAnimation::setRecoil(int duration, int spread)
+{
+    m_recoilDuration = qMax(0, duration);
+    m_recoilSpread = spread;
+    m_recoilTimeline.setDuration(qMax(1, m_recoilDuration));
+}
+
+void CrosshairAnimation::reset()
+{
+    m_fadeTimeline.setCurrentTime(0);
+    m_fadeRunning = false;
+    m_fadingOut = false;
+    m_pulseRunning = false;
+    m_recoilRunning = false;
+}
+
+bool CrosshairAnimation::isAnimating() const
+{
+    return m_fadeRunning || m_pulseRunning || m_recoilRunning;
+}
+
+void CrosshairAnimation::fadeIn()
+{
+    m_fadeTimeline.setCurrentTime(0);
+    m_fadingOut = false;
+    m_fadeRunning = true;
+}
+
+void CrosshairAnimation::reverseFade()
+{
+    m_fadingOut = !m_fadingOut;
+    m_fadeRunning = true;
+}
+
+bool CrosshairAnimation::pulse()
+{
+    if (m_pulseDuration <= 0) {
+        return false;
+    }
+    m_pulseTimeline.setCurrentTime(0);
+    m_pulseRunning = true;
+    return true;
+}
+
+bool CrosshairAnimation::recoil()
+{
+    if (m_recoilDuration <= 0) {
+        return false;
+    }
+    m_recoilTimeline.setCurrentTime(0);
+    m_recoilRunning = true;
+    return true;
+}
+
+CrosshairAnimation::Frame CrosshairAnimation::prePaint(int time)
+{
+    if (!isAnimating()) {
+        return Unchanged;
+    }
+    return advance(time) ? FadedOut : Changed;
+}
+
+bool CrosshairAnimation::advance(int time)
+{
+    bool fadedOut = false;
+
+    // Time is what passed since the previous frame, not wall-clock timers
+    if (m_fadeRunning) {
+        const int t = m_fadeTimeline.currentTime() + (m_fadingOut ? -time : time);
+        m_fadeTimeline.setCurrentTime(qBound(0, t, m_fadeDuration));
+        if (m_fadingOut && t <= 0) {
+            m_fadeRunning = false;
+            m_fadingOut = false;
+            fadedOut = true;
+        } else if (!m_fadingOut && t >= m_fadeDuration) {
+            m_fadeRunning = false;
+        }
+    }
+
+    if (m_pulseRunning) {
+        const int t = m_pulseTimeline.currentTime() + time;
+        m_pulseTimeline.setCurrentTime(qMin(t, m_pulseDuration));
+        m_pulseRunning = (t < m_pulseDuration);
+    }
+
+    if (m_recoilRunning) {
+        const int t = m_recoilTimeline.currentTime() + time;
+        m_recoilTimeline.setCurrentTime(qMin(t, m_recoilDuration));
+        m_recoilRunning = (t < m_recoilDuration);
+    }
+
+    return fadedOut;
+}
+
+float CrosshairAnimation::opacity() const
+{
+    return m_fadeDuration > 0 ? m_fadeTimeline.currentValue() : 1.0f;
+}
+
+float CrosshairAnimation::scale() const
+{
+    return m_pulseRunning ? 1.0f + m_pulseScale * m_pulseTimeline.currentValue() : 1.0f;
+}
+
+float CrosshairAnimation::spread() const
+{
+    // Jumps out at once, then settles back
+    return m_recoilRunning ? m_recoilSpread * (1.0f - m_recoilTimeline.currentValue()) : 0.0f;
+}
+
+} // namespace
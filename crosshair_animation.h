@@ -0,0 +1,97 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2013 Pawel Bartkiewicz <tuuresairon@gmail.com>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+
+#ifndef KWIN_CROSSHAIR_ANIMATION_H
+#define KWIN_CROSSHAIR_ANIMATION_H
+
+#include <QTimeLine>
+
+namespace KWin
+{
+
+/* Fade, pulse and recoil of the crosshair, advanced by the frame time in
+ * prePaintScreen. The timelines are never started, they only map time to
+ * eased values, so no timer runs. Which frames advance the animations and
+ * which ask for another one is decided by prePaint() and needsRepaint(),
+ * the calls the effect makes from prePaintScreen and postPaintScreen. */
+class CrosshairAnimation
+{
+public:
+
+    enum Frame {
+        Unchanged,  // Nothing is animating
+        Changed,    // The crosshair has to be repainted
+        FadedOut    // The crosshair has to be repainted and hidden
+    };
+
+    CrosshairAnimation();
+
+    /* Durations in ms, 0 disables the animation */
+    void setFade(int duration);
+    void setPulse(int duration, float scale);
+    void setRecoil(int duration, int spread);
+
+    /* Stops everything, a hidden crosshair fades in from transparent */
+    void reset();
+
+    bool hasFade() const { return m_fadeDuration > 0; }
+    bool isAnimating() const;
+
+    void fadeIn();
+    /* Fades out a shown crosshair, or reverses a fade that is running */
+    void reverseFade();
+    /* Restart the animation; false if it is disabled */
+    bool pulse();
+    bool recoil();
+
+    /* Called from prePaintScreen, advances the running animations by the
+     * frame time in ms */
+    Frame prePaint(int time);
+    /* Called from postPaintScreen, true while another frame is needed. The
+     * frame in which the animations end is painted, but asks for no more. */
+    bool needsRepaint() const { return isAnimating(); }
+
+    float opacity() const;
+    /* Factor and pixels added to the crosshair size */
+    float scale() const;
+    float spread() const;
+
+private:
+
+    /* Returns true when a fade out finishes */
+    bool advance(int time);
+
+    int m_fadeDuration;
+    int m_pulseDuration;
+    float m_pulseScale;
+    int m_recoilDuration;
+    int m_recoilSpread;
+    QTimeLine m_fadeTimeline;
+    QTimeLine m_pulseTimeline;
+    QTimeLine m_recoilTimeline;
+    bool m_fadeRunning;
+    bool m_fadingOut;
+    bool m_pulseRunning;
+    bool m_recoilRunning;
+};
+
+} // namespace
+
+#endif
@@ -54,7 +54,10 @@ CrosshairEffectConfig::CrosshairEffectConfig(QWidget* parent, const QVariantList
     connect(m_ui->editor, SIGNAL(keyChange()), this, SLOT(changed()));
     connect(m_ui->spinSize, SIGNAL(valueChanged(int)), this, SLOT(changed()));
     connect(m_ui->spinWidth, SIGNAL(valueChanged(int)), this, SLOT(changed()));
+    connect(m_ui->outlineWidthSpinBox, SIGNAL(valueChanged(int)), this, SLOT(changed()));
+    connect(m_ui->outlineColorCombo, SIGNAL(currentIndexChanged(int)), this, SLOT(changed()));
     connect(m_ui->comboColors, SIGNAL(currentIndexChanged(int)), this, SLOT(changed()));
+    connect(m_ui->adaptiveColorCheckBox, SIGNAL(toggled(bool)), this, SLOT(changed()));
     connect(m_ui->spinAlpha, SIGNAL(valueChanged(int)), this, SLOT(changed()));
     connect(m_ui->blendComboBox, SIGNAL(currentIndexChanged(int)), this, SLOT(changed()));
     connect(m_ui->shapeComboBox, SIGNAL(currentIndexChanged(int)), this, SLOT(changed()));
@@ -64,9 +67,23 @@ CrosshairEffectConfig::CrosshairEffectConfig(QWidget* parent, const QVariantList
     connect(m_ui->offsetYSpinBox, SIGNAL(valueChanged(int)), this, SLOT(changed()));
     connect(m_ui->imageKUrlRequester, SIGNAL(textChanged(QString)), this, SLOT(changed()));
     connect(m_ui->imageKUrlRequester, SIGNAL(urlSelected(KUrl)), this, SLOT(changed()));
+    connect(m_ui->nudgeStepSpinBox, SIGNAL(valueChanged(int)), this, SLOT(changed()));
+    connect(m_ui->nudgeMaxStepSpinBox, SIGNAL(valueChanged(int)), this, SLOT(changed()));
+    connect(m_ui->autoSaveOffsetCheckBox, SIGNAL(toggled(bool)), this, SLOT(changed()));
+    connect(m_ui->releaseDelaySpinBox, SIGNAL(valueChanged(int)), this, SLOT(changed()));
+    connect(m_ui->feedCheckBox, SIGNAL(toggled(bool)), this, SLOT(changed()));
+    connect(m_ui->fadeDurationSpinBox, SIGNAL(valueChanged(int)), this, SLOT(changed()));
+    connect(m_ui->pulseDurationSpinBox, SIGNAL(valueChanged(int)), this, SLOT(changed()));
+    connect(m_ui->recoilSpreadSpinBox, SIGNAL(valueChanged(int)), this, SLOT(changed()));
+    connect(m_ui->magnifierGroupBox, SIGNAL(toggled(bool)), this, SLOT(changed()));
+    connect(m_ui->magnifierShapeComboBox, SIGNAL(currentIndexChanged(int)), this, SLOT(changed()));
+    connect(m_ui->magnifierSizeSpinBox, SIGNAL(valueChanged(int)), this, SLOT(changed()));
+    connect(m_ui->magnifierZoomSpinBox, SIGNAL(valueChanged(int)), this, SLOT(changed()));
+    connect(m_ui->magnifierSmoothCheckBox, SIGNAL(toggled(bool)), this, SLOT(changed()));
 
     connect(m_ui->blendComboBox, SIGNAL(currentIndexChanged(int)), this, SLOT(blendChanged(int)));
     connect(m_ui->shapeComboBox, SIGNAL(currentIndexChanged(int)), this, SLOT(shapeChanged(int)));
+    connect(m_ui->outlineWidthSpinBox, SIGNAL(valueChanged(int)), this, SLOT(outlineWidthChanged(int)));
 
     // Shortcut config. The shortcut belongs to the component "kwin"!
     m_actionCollection = new KActionCollection(this, KComponentData("kwin"));
@@ -98,6 +115,16 @@ CrosshairEffectConfig::CrosshairEffectConfig(QWidget* parent, const QVariantList
     a->setProperty("isConfigurationAction", true);
     a->setGlobalShortcut(KShortcut());
 
+    a = static_cast<KAction*>(m_actionCollection->addAction("PulseCrosshair"));
+    a->setText(i18n("Pulse Crosshair"));
+    a->setProperty("isConfigurationAction", true);
+    a->setGlobalShortcut(KShortcut());
+
+    a = static_cast<KAction*>(m_actionCollection->addAction("RecoilCrosshair"));
+    a->setText(i18n("Recoil Crosshair"));
+    a->setProperty("isConfigurationAction", true);
+    a->setGlobalShortcut(KShortcut());
+
     a = static_cast<KAction*>(m_actionCollection->addAction("ResetCrosshairOffset"));
     a->setText(i18n("Reset Crosshair Offset"));
     a->setProperty("isConfigurationAction", true);
@@ -127,7 +154,10 @@ void CrosshairEffectConfig::load()
 
     int size  = conf.readEntry("Size", 20);
     int width = conf.readEntry("LineWidth", 1);
+    int outlineWidth = conf.readEntry("OutlineWidth", 0);
+    QColor outlineColor = conf.readEntry("OutlineColor", QColor(0, 0, 0));
     QColor color = conf.readEntry("Color", QColor(255, 48, 48));
+    bool adaptiveColor = conf.readEntry("AdaptiveColor", false);
     int alpha = conf.readEntry("Alpha", 100);
     int shape = conf.readEntry("Shape", 0);
     int blend = conf.readEntry("Blend", 6);
@@ -135,24 +165,64 @@ void CrosshairEffectConfig::load()
     bool roundPosition = conf.readEntry("RoundPosition", true);
     int offsetX = conf.readEntry("OffsetX", 0);
     int offsetY = conf.readEntry("OffsetY", 0);
+    int nudgeStep = conf.readEntry("NudgeStep", 1);
+    int nudgeMaxStep = conf.readEntry("NudgeMaxStep", 1);
+    bool autoSaveOffset = conf.readEntry("AutoSaveOffset", false);
     QString imagePath = conf.readEntry("Image", KGlobal::dirs()->findResource("data", "kwin/crosshair_glow.png"));
+    int releaseDelay = conf.readEntry("ReleaseDelay", 0);
+    bool feed = conf.readEntry("Feed", false);
+    int fadeDuration = conf.readEntry("FadeDuration", 0);
+    int pulseDuration = conf.readEntry("PulseDuration", 300);
+    int recoilSpread = conf.readEntry("RecoilSpread", 10);
+    bool magnifier = conf.readEntry("Magnifier", false);
+    int magnifierShape = conf.readEntry("MagnifierShape", 0);
+    int magnifierSize = conf.readEntry("MagnifierSize", 100);
+    int magnifierZoom = conf.readEntry("MagnifierZoom", 200);
+    bool magnifierSmooth = conf.readEntry("MagnifierSmooth", true);
     m_ui->spinSize->setValue(size);
     m_ui->spinSize->setSuffix(ki18np(" pixel", " pixels"));
     m_ui->spinWidth->setValue(width);
     m_ui->spinWidth->setSuffix(ki18np(" pixel", " pixels"));
+    m_ui->outlineWidthSpinBox->setValue(outlineWidth);
+    m_ui->outlineWidthSpinBox->setSuffix(ki18np(" pixel", " pixels"));
+    m_ui->outlineColorCombo->setColor(outlineColor);
     m_ui->spinAlpha->setValue(alpha);
     m_ui->spinAlpha->setSuffix(ki18np("%", "%"));
     m_ui->comboColors->setColor(color);
+    m_ui->adaptiveColorCheckBox->setChecked(adaptiveColor);
     m_ui->shapeComboBox->setCurrentIndex(shape);
     m_ui->blendComboBox->setCurrentIndex(blend);
     m_ui->positionComboBox->setCurrentIndex(position);
     m_ui->roundPositionCheckBox->setChecked(roundPosition);
     m_ui->offsetXSpinBox->setValue(offsetX);
     m_ui->offsetYSpinBox->setValue(offsetY);
+    m_ui->nudgeStepSpinBox->setValue(nudgeStep);
+    m_ui->nudgeStepSpinBox->setSuffix(ki18np(" pixel", " pixels"));
+    m_ui->nudgeMaxStepSpinBox->setValue(nudgeMaxStep);
+    m_ui->nudgeMaxStepSpinBox->setSuffix(ki18np(" pixel", " pixels"));
+    m_ui->autoSaveOffsetCheckBox->setChecked(autoSaveOffset);
     m_ui->imageKUrlRequester->setUrl(imagePath);
+    m_ui->releaseDelaySpinBox->setValue(releaseDelay);
+    m_ui->releaseDelaySpinBox->setSuffix(ki18np(" second", " seconds"));
+    m_ui->feedCheckBox->setChecked(feed);
+    m_ui->fadeDurationSpinBox->setValue(fadeDuration);
+    m_ui->fadeDurationSpinBox->setSuffix(ki18np(" millisecond", " milliseconds"));
+    m_ui->pulseDurationSpinBox->setValue(pulseDuration);
+    m_ui->pulseDurationSpinBox->setSuffix(ki18np(" millisecond", " milliseconds"));
+    m_ui->recoilSpreadSpinBox->setValue(recoilSpread);
+    m_ui->recoilSpreadSpinBox->setSuffix(ki18np(" pixel", " pixels"));
+    m_ui->magnifierGroupBox->setChecked(magnifier);
+    m_ui->magnifierShapeComboBox->setCurrentIndex(magnifierShape);
+    m_ui->magnifierSizeSpinBox->setValue(magnifierSize);
+    m_ui->magnifierSizeSpinBox->setSuffix(ki18np(" pixel", " pixels"));
+    m_ui->magnifierZoomSpinBox->setValue(magnifierZoom);
+    m_ui->magnifierZoomSpinBox->setSuffix(ki18np("%", "%"));
+    m_ui->magnifierSmoothCheckBox->setChecked(magnifierSmooth);
 
     m_ui->spinAlpha->setEnabled(blend > 0);
     m_ui->spinWidth->setEnabled(shape > 0);
+    m_ui->outlineWidthSpinBox->setEnabled(shape > 0);
+    m_ui->outlineColorCombo->setEnabled(shape > 0 && outlineWidth > 0);
     m_ui->imageKUrlRequester->setEnabled(shape == 0);
 
     emit changed(false);
@@ -167,7 +237,10 @@ void CrosshairEffectConfig::save()
 
     conf.writeEntry("Size", m_ui->spinSize->value());
     conf.writeEntry("LineWidth", m_ui->spinWidth->value());
+    conf.writeEntry("OutlineWidth", m_ui->outlineWidthSpinBox->value());
+    conf.writeEntry("OutlineColor", m_ui->outlineColorCombo->color());
     conf.writeEntry("Color", m_ui->comboColors->color());
+    conf.writeEntry("AdaptiveColor", m_ui->adaptiveColorCheckBox->isChecked());
     conf.writeEntry("Alpha", m_ui->spinAlpha->value());
     conf.writeEntry("Shape", m_ui->shapeComboBox->currentIndex());
     conf.writeEntry("Blend", m_ui->blendComboBox->currentIndex());
@@ -175,7 +248,20 @@ void CrosshairEffectConfig::save()
     conf.writeEntry("RoundPosition", m_ui->roundPositionCheckBox->isChecked());
     conf.writeEntry("OffsetX", m_ui->offsetXSpinBox->value());
     conf.writeEntry("OffsetY", m_ui->offsetYSpinBox->value());
+    conf.writeEntry("NudgeStep", m_ui->nudgeStepSpinBox->value());
+    conf.writeEntry("NudgeMaxStep", m_ui->nudgeMaxStepSpinBox->value());
+    conf.writeEntry("AutoSaveOffset", m_ui->autoSaveOffsetCheckBox->isChecked());
     conf.writeEntry("Image", m_ui->imageKUrlRequester->url().pathOrUrl());
+    conf.writeEntry("ReleaseDelay", m_ui->releaseDelaySpinBox->value());
+    conf.writeEntry("Feed", m_ui->feedCheckBox->isChecked());
+    conf.writeEntry("FadeDuration", m_ui->fadeDurationSpinBox->value());
+    conf.writeEntry("PulseDuration", m_ui->pulseDurationSpinBox->value());
+    conf.writeEntry("RecoilSpread", m_ui->recoilSpreadSpinBox->value());
+    conf.writeEntry("Magnifier", m_ui->magnifierGroupBox->isChecked());
+    conf.writeEntry("MagnifierShape", m_ui->magnifierShapeComboBox->currentIndex());
+    conf.writeEntry("MagnifierSize", m_ui->magnifierSizeSpinBox->value());
+    conf.writeEntry("MagnifierZoom", m_ui->magnifierZoomSpinBox->value());
+    conf.writeEntry("MagnifierSmooth", m_ui->magnifierSmoothCheckBox->isChecked());
 
     m_actionCollection->writeSettings();
     m_ui->editor->save();   // undo() will restore to this state from now on
@@ -190,7 +276,10 @@ void CrosshairEffectConfig::defaults()
 {
     m_ui->spinSize->setValue(20);
     m_ui->spinWidth->setValue(1);
+    m_ui->outlineWidthSpinBox->setValue(0);
+    m_ui->outlineColorCombo->setColor(QColor(0, 0, 0));
     m_ui->comboColors->setColor(QColor(255, 48, 48));
+    m_ui->adaptiveColorCheckBox->setChecked(false);
     m_ui->spinAlpha->setValue(100);
     m_ui->shapeComboBox->setCurrentIndex(0);
     m_ui->blendComboBox->setCurrentIndex(6);
@@ -198,7 +287,20 @@ void CrosshairEffectConfig::defaults()
     m_ui->roundPositionCheckBox->setChecked(true);
     m_ui->offsetXSpinBox->setValue(0);
     m_ui->offsetYSpinBox->setValue(0);
+    m_ui->nudgeStepSpinBox->setValue(1);
+    m_ui->nudgeMaxStepSpinBox->setValue(1);
+    m_ui->autoSaveOffsetCheckBox->setChecked(false);
     m_ui->imageKUrlRequester->setUrl(KGlobal::dirs()->findResource("data", "kwin/crosshair_glow.png"));
+    m_ui->releaseDelaySpinBox->setValue(0);
+    m_ui->feedCheckBox->setChecked(false);
+    m_ui->fadeDurationSpinBox->setValue(0);
+    m_ui->pulseDurationSpinBox->setValue(300);
+    m_ui->recoilSpreadSpinBox->setValue(10);
+    m_ui->magnifierGroupBox->setChecked(false);
+    m_ui->magnifierShapeComboBox->setCurrentIndex(0);
+    m_ui->magnifierSizeSpinBox->setValue(100);
+    m_ui->magnifierZoomSpinBox->setValue(200);
+    m_ui->magnifierSmoothCheckBox->setChecked(true);
 
     emit changed(true);
 }
@@ -211,9 +313,16 @@ void CrosshairEffectConfig::blendChanged(int index)
 void CrosshairEffectConfig::shapeChanged(int index)
 {
     m_ui->spinWidth->setEnabled(index > 0);
+    m_ui->outlineWidthSpinBox->setEnabled(index > 0);
+    m_ui->outlineColorCombo->setEnabled(index > 0 && m_ui->outlineWidthSpinBox->value() > 0);
     m_ui->imageKUrlRequester->setEnabled(index == 0);
 }
 
+void CrosshairEffectConfig::outlineWidthChanged(int value)
+{
+    m_ui->outlineColorCombo->setEnabled(value > 0 && m_ui->shapeComboBox->currentIndex() > 0);
+}
+
 } // namespace
 
 #include "crosshair_config.moc"
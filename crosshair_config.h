@@ -56,6 +56,7 @@ private slots:
 
     void blendChanged(int index);
     void shapeChanged(int index);
+    void outlineWidthChanged(int value);
 
 private:
 
@@ -0,0 +1,257 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2013 Pawel Bartkiewicz <tuuresairon@gmail.com>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+
+#include "crosshair_feed.h"
+
+#include <kdebug.h>
+#include <kstandarddirs.h>
+
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QTimer>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace KWin
+{
+
+// Polling the sequence number is a single load, do it at about 120 Hz
+static const int FEED_POLL_INTERVAL = 8;
+// Give up on a frame if the writer keeps the slot busy for this many tries
+static const int FEED_READ_TRIES = 4;
+
+static qint64 monotonicTime()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return qint64(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+CrosshairFeed::CrosshairFeed(QObject* parent)
+    : QObject(parent)
+    , m_server(NULL)
+    , m_client(NULL)
+    , m_slot(NULL)
+    , m_readSequence(0)
+    , m_readTime(0)
+    , m_polledSequence(0)
+    , m_active(false)
+{
+    m_name = QString("/kwin-crosshair-feed-%1").arg(getuid());
+
+    m_pollTimer = new QTimer(this);
+    connect(m_pollTimer, SIGNAL(timeout()), this, SLOT(poll()));
+}
+
+CrosshairFeed::~CrosshairFeed()
+{
+    stop();
+}
+
+bool CrosshairFeed::start()
+{
+    if (m_server != NULL) {
+        return true;
+    }
+
+    // The name is predictable and /dev/shm is shared by all users, so never
+    // reuse an existing object: one left by a crashed KWin is removed, and
+    // one created by somebody else can't be and makes this fail
+    const QByteArray name = m_name.toLocal8Bit();
+    shm_unlink(name.constData());
+    int fd = shm_open(name.constData(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd == -1) {
+        kDebug() << "Cannot create shared memory" << m_name << strerror(errno);
+        return false;
+    }
+
+    void* memory = MAP_FAILED;
+    if (ftruncate(fd, sizeof(CrosshairFeedSlot)) == 0) {
+        memory = mmap(NULL, sizeof(CrosshairFeedSlot), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+
+    if (memory == MAP_FAILED) {
+        kDebug() << "Cannot map shared memory" << m_name;
+        shm_unlink(name.constData());
+        return false;
+    }
+
+    m_slot = static_cast<CrosshairFeedSlot*>(memory);
+    memset(m_slot, 0, sizeof(CrosshairFeedSlot));
+    m_slot->magic   = CROSSHAIR_FEED_MAGIC;
+    m_slot->version = CROSSHAIR_FEED_VERSION;
+    m_readSequence   = 0;
+    m_readTime       = 0;
+    m_polledSequence = 0;
+
+    const QString socket = KStandardDirs::locateLocal("socket", CROSSHAIR_FEED_SOCKET);
+    QLocalServer::removeServer(socket);
+
+    m_server = new QLocalServer(this);
+    connect(m_server, SIGNAL(newConnection()), this, SLOT(slotNewConnection()));
+    if (!m_server->listen(socket)) {
+        kDebug() << "Cannot listen on" << socket << m_server->errorString();
+        stop();
+        return false;
+    }
+
+    return true;
+}
+
+void CrosshairFeed::stop()
+{
+    m_pollTimer->stop();
+
+    if (m_client != NULL) {
+        m_client->disconnect(this);
+        m_client->deleteLater();
+        m_client = NULL;
+    }
+
+    if (m_server != NULL) {
+        m_server->close();
+        delete m_server;
+        m_server = NULL;
+    }
+
+    if (m_slot != NULL) {
+        munmap(m_slot, sizeof(CrosshairFeedSlot));
+        shm_unlink(m_name.toLocal8Bit().constData());
+        m_slot = NULL;
+    }
+}
+
+bool CrosshairFeed::hasClients() const
+{
+    return m_client != NULL;
+}
+
+void CrosshairFeed::setActive(bool active)
+{
+    m_active = active;
+    updatePolling();
+}
+
+void CrosshairFeed::updatePolling()
+{
+    // Nothing would be repainted, so don't wake up for it
+    if (m_active && m_client != NULL) {
+        if (!m_pollTimer->isActive()) {
+            m_pollTimer->start(FEED_POLL_INTERVAL);
+        }
+    } else {
+        m_pollTimer->stop();
+    }
+}
+
+bool CrosshairFeed::read(CrosshairFeedSlot& slot)
+{
+    if (m_slot == NULL) {
+        return false;
+    }
+
+    for (int i = 0; i < FEED_READ_TRIES; ++i) {
+        const quint32 begin = m_slot->sequence;
+        if (begin & 1) {
+            continue;
+        }
+        if (begin == m_readSequence) {
+            return false;
+        }
+
+        __sync_synchronize();
+        memcpy(&slot, const_cast<CrosshairFeedSlot*>(m_slot), sizeof(slot));
+        __sync_synchronize();
+
+        if (m_slot->sequence == begin) {
+            m_readSequence = begin;
+            m_readTime = monotonicTime();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void CrosshairFeed::poll()
+{
+    const quint32 sequence = m_slot->sequence;
+    if (sequence != m_polledSequence && !(sequence & 1)) {
+        m_polledSequence = sequence;
+        emit updated();
+    }
+}
+
+void CrosshairFeed::slotNewConnection()
+{
+    bool changed = false;
+    while (QLocalSocket* client = m_server->nextPendingConnection()) {
+        if (m_client != NULL) {
+            // The seqlock allows only one writer, further clients are turned
+            // away until the current one disconnects
+            connect(client, SIGNAL(disconnected()), client, SLOT(deleteLater()));
+            client->write(CROSSHAIR_FEED_BUSY "\n");
+            client->disconnectFromServer();
+            continue;
+        }
+
+        connect(client, SIGNAL(disconnected()), this, SLOT(slotDisconnected()));
+        client->write(QString("KWIN-CROSSHAIR-FEED %1 %2\n")
+                      .arg(CROSSHAIR_FEED_VERSION).arg(m_name).toLocal8Bit());
+        m_client = client;
+        changed = true;
+    }
+
+    if (changed) {
+        updatePolling();
+        emit clientsChanged();
+    }
+}
+
+void CrosshairFeed::slotDisconnected()
+{
+    QLocalSocket* client = qobject_cast<QLocalSocket*>(sender());
+    if (client == NULL || client != m_client) {
+        return;
+    }
+    client->deleteLater();
+    m_client = NULL;
+
+    // A writer that went away mid-update leaves the sequence odd. Make it
+    // even for the next writer, without accepting the torn update.
+    if (m_slot->sequence & 1) {
+        m_slot->sequence = m_slot->sequence + 1;
+        m_readSequence   = m_slot->sequence;
+        m_polledSequence = m_slot->sequence;
+    }
+
+    updatePolling();
+    emit clientsChanged();
+}
+
+} // namespace
+
+#include "crosshair_feed.moc"
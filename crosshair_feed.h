@@ -0,0 +1,94 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2013 Pawel Bartkiewicz <tuuresairon@gmail.com>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+
+#ifndef KWIN_CROSSHAIR_FEED_H
+#define KWIN_CROSSHAIR_FEED_H
+
+#include <QObject>
+#include <QString>
+
+#include "crosshair_feed_protocol.h"
+
+class QLocalServer;
+class QLocalSocket;
+class QTimer;
+
+namespace KWin
+{
+
+/* Server side of the shared-memory position feed, see
+ * crosshair_feed_protocol.h for the client side. */
+class CrosshairFeed
+    : public QObject
+{
+    Q_OBJECT
+
+public:
+
+    explicit CrosshairFeed(QObject* parent = 0);
+    ~CrosshairFeed();
+
+    bool start();
+    void stop();
+
+    bool hasClients() const;
+
+    /* The slot is only polled while the feed is active and has clients */
+    void setActive(bool active);
+
+    /* Copies the latest complete update into slot. Returns false if there
+     * is nothing new or a writer kept the slot busy. Never blocks. */
+    bool read(CrosshairFeedSlot& slot);
+
+    /* Sequence number of the last update read, and the CLOCK_MONOTONIC
+     * time in nanoseconds at which it was read */
+    quint32 lastSequence() const { return m_readSequence; }
+    qint64 lastReadTime() const { return m_readTime; }
+
+signals:
+
+    /* A new update was published (checked at about frame rate) */
+    void updated();
+    void clientsChanged();
+
+private slots:
+
+    void slotNewConnection();
+    void slotDisconnected();
+    void poll();
+
+private:
+
+    void updatePolling();
+
+    QLocalServer* m_server;
+    QLocalSocket* m_client; /* The single writer, see the protocol */
+    QTimer* m_pollTimer;
+    QString m_name;
+    CrosshairFeedSlot* m_slot;
+    quint32 m_readSequence;
+    qint64 m_readTime;
+    quint32 m_polledSequence;
+    bool m_active;
+};
+
+} // namespace
+
+#endif
@@ -0,0 +1,78 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2013 Pawel Bartkiewicz <tuuresairon@gmail.com>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+
+/* Shared-memory position feed, usable from C and C++ clients.
+ *
+ * 1. Connect to the Unix socket $KDEHOME/socket-$HOSTNAME/kwin-crosshair-feed
+ *    and read one line: "KWIN-CROSSHAIR-FEED <version> <shm name>\n".
+ *    Keep the connection open, the effect only follows the feed while the
+ *    client is connected. While another client is connected the effect
+ *    sends CROSSHAIR_FEED_BUSY instead and closes the connection.
+ * 2. shm_open() the name, mmap() sizeof(struct CrosshairFeedSlot) bytes
+ *    read/write and check magic and version.
+ * 3. Publish every update with crosshair_feed_write(), which takes no
+ *    system calls. The effect picks up the latest value each frame.
+ *
+ * Only one client is accepted at a time, so there is a single writer. */
+
+#ifndef KWIN_CROSSHAIR_FEED_PROTOCOL_H
+#define KWIN_CROSSHAIR_FEED_PROTOCOL_H
+
+#include <stdint.h>
+
+#define CROSSHAIR_FEED_MAGIC    0x4b574346u  /* "KWCF" */
+#define CROSSHAIR_FEED_VERSION  1u
+#define CROSSHAIR_FEED_SOCKET   "kwin-crosshair-feed"
+/* Sent instead of the greeting while another client is connected */
+#define CROSSHAIR_FEED_BUSY     "KWIN-CROSSHAIR-FEED-BUSY"
+
+/* Fields present in an update */
+#define CROSSHAIR_FEED_POSITION 0x1u
+#define CROSSHAIR_FEED_SHAPE    0x2u
+#define CROSSHAIR_FEED_COLOR    0x4u
+
+struct CrosshairFeedSlot
+{
+    uint32_t magic;
+    uint32_t version;
+    volatile uint32_t sequence;  /* Odd while an update is being written */
+    uint32_t flags;              /* CROSSHAIR_FEED_* */
+    float x;                     /* Centre, in global screen coordinates */
+    float y;
+    int32_t shape;               /* Same values as the Shape config entry */
+    uint32_t color;              /* 0xAARRGGBB */
+};
+
+/* Seqlock write of a whole update */
+static inline void crosshair_feed_write(struct CrosshairFeedSlot* slot, uint32_t flags,
+                                        float x, float y, int32_t shape, uint32_t color)
+{
+    slot->sequence = slot->sequence + 1;
+    __sync_synchronize();
+    slot->flags = flags;
+    slot->x     = x;
+    slot->y     = y;
+    slot->shape = shape;
+    slot->color = color;
+    __sync_synchronize();
+    slot->sequence = slot->sequence + 1;
+}
+
+#endif
@@ -0,0 +1,135 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2013 Pawel Bartkiewicz <tuuresairon@gmail.com>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+
+#include "crosshair_texture_cache.h"
+
+#include <ksavefile.h>
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFileInfo>
+
+#include <string.h>
+
+namespace KWin
+{
+
+struct CacheHeader
+{
+    char magic[4];
+    quint32 width;
+    quint32 height;
+    quint32 bytesPerLine;
+    quint32 format;
+};
+
+static const char CACHE_MAGIC[4] = { 'K', 'W', 'C', '1' };
+static const QImage::Format CACHE_FORMAT = QImage::Format_ARGB32_Premultiplied;
+
+QString CrosshairTextureCache::key(const QByteArray& data, int size)
+{
+    // Hashing the file is much cheaper than decoding it
+    return QString("%1-%2-%3")
+           .arg(QString(QCryptographicHash::hash(data, QCryptographicHash::Sha1).toHex()))
+           .arg(size)
+           .arg(static_cast<int>(CACHE_FORMAT));
+}
+
+QImage CrosshairTextureCache::decode(const QByteArray& data, int size)
+{
+    const QImage image = QImage::fromData(data);
+    if (image.isNull()) {
+        return image;
+    }
+    return image.convertToFormat(CACHE_FORMAT)
+                .scaled(size, size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+}
+
+CrosshairTextureCache::CrosshairTextureCache(const QString& path)
+    : m_path(path)
+    , m_file(path)
+    , m_mapped(NULL)
+{
+}
+
+CrosshairTextureCache::~CrosshairTextureCache()
+{
+    if (m_mapped != NULL) {
+        m_file.unmap(m_mapped);
+    }
+}
+
+QImage CrosshairTextureCache::load(int size)
+{
+    if (m_mapped != NULL || !m_file.open(QIODevice::ReadOnly)
+            || m_file.size() < qint64(sizeof(CacheHeader))) {
+        return QImage();
+    }
+    m_mapped = m_file.map(0, m_file.size());
+    if (m_mapped == NULL) {
+        return QImage();
+    }
+
+    // Anything in the cache directory may be truncated or corrupt, the
+    // header is checked before the pixels are touched
+    const CacheHeader* header = reinterpret_cast<const CacheHeader*>(m_mapped);
+    if (memcmp(header->magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0
+            || header->format != static_cast<quint32>(CACHE_FORMAT)
+            || header->width != static_cast<quint32>(size)
+            || header->height != static_cast<quint32>(size)
+            || header->bytesPerLine < 4 * qint64(header->width)
+            || header->bytesPerLine % 4 != 0
+            || m_file.size() != qint64(sizeof(CacheHeader))
+                                + qint64(header->bytesPerLine) * qint64(header->height)) {
+        return QImage();
+    }
+    return QImage(m_mapped + sizeof(CacheHeader),
+                  header->width, header->height, header->bytesPerLine, CACHE_FORMAT);
+}
+
+bool CrosshairTextureCache::store(const QImage& image)
+{
+    const QImage pixels = image.convertToFormat(CACHE_FORMAT);
+
+    CacheHeader header;
+    memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.width        = pixels.width();
+    header.height       = pixels.height();
+    header.bytesPerLine = pixels.bytesPerLine();
+    header.format       = static_cast<quint32>(CACHE_FORMAT);
+
+    KSaveFile out(m_path);
+    if (!out.open()) {
+        return false;
+    }
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(pixels.constBits()), pixels.byteCount());
+    return out.finalize();
+}
+
+void CrosshairTextureCache::expire(int maxEntries)
+{
+    const QFileInfoList entries = QFileInfo(m_path).dir().entryInfoList(QDir::Files, QDir::Time);
+    for (int i = maxEntries; i < entries.size(); ++i) {
+        QFile::remove(entries[i].absoluteFilePath());
+    }
+}
+
+} // namespace
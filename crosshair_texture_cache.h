@@ -0,0 +1,64 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2013 Pawel Bartkiewicz <tuuresairon@gmail.com>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+
+#ifndef KWIN_CROSSHAIR_TEXTURE_CACHE_H
+#define KWIN_CROSSHAIR_TEXTURE_CACHE_H
+
+#include <QFile>
+#include <QImage>
+
+namespace KWin
+{
+
+/* One processed crosshair image cached on disk as raw, premultiplied pixels
+ * already scaled to the rendered size, so loading it doesn't involve any
+ * decoding or conversion. Only needs QtGui, so the benchmark in tests/
+ * times the same code the effect runs. */
+class CrosshairTextureCache
+{
+public:
+
+    /* Name of the entry for an image file at the given size, which is
+     * both the width and the height */
+    static QString key(const QByteArray& data, int size);
+    /* The slow path: decodes, premultiplies and scales the image file */
+    static QImage decode(const QByteArray& data, int size);
+
+    explicit CrosshairTextureCache(const QString& path);
+    ~CrosshairTextureCache();
+
+    /* Maps the entry. Returns a null image if it is missing, truncated or
+     * not size x size, otherwise one referring to the mapping, which lasts
+     * until the cache object is destroyed. */
+    QImage load(int size);
+    bool store(const QImage& image);
+    /* Drops all but the maxEntries most recently written entries */
+    void expire(int maxEntries);
+
+private:
+
+    QString m_path;
+    QFile m_file;
+    uchar* m_mapped;
+};
+
+} // namespace
+
+#endif
@@ -0,0 +1,88 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2013 Pawel Bartkiewicz <tuuresairon@gmail.com>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+
+#include "crosshair_trace.h"
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QTextStream>
+
+namespace KWin
+{
+
+CrosshairTrace::CrosshairTrace()
+    : m_events(NULL)
+    , m_next(0)
+{
+    m_clock.start();
+}
+
+CrosshairTrace::~CrosshairTrace()
+{
+    delete[] m_events;
+}
+
+void CrosshairTrace::setEnabled(bool enabled)
+{
+    if (enabled && m_events == NULL) {
+        m_events = new Event[CAPACITY];
+        m_next = 0;
+    } else if (!enabled) {
+        delete[] m_events;
+        m_events = NULL;
+    }
+}
+
+bool CrosshairTrace::dump(const QString& fileName) const
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+
+    const uint total = m_events != NULL ? static_cast<uint>(static_cast<int>(m_next)) : 0;
+    const uint count = qMin(total, static_cast<uint>(CAPACITY));
+    const qint64 pid = QCoreApplication::applicationPid();
+
+    QTextStream out(&file);
+    out << "{\"traceEvents\":[";
+    for (uint i = total - count; i != total; ++i) {
+        const Event& e = m_events[i % CAPACITY];
+        if (i != total - count) {
+            out << ",";
+        }
+        // Timestamps are in microseconds
+        out << "\n{\"name\":\"" << e.name << "\",\"cat\":\"crosshair\""
+            << ",\"ph\":\"" << e.phase << "\""
+            << ",\"ts\":" << QString::number(e.start / 1000.0, 'f', 3);
+        if (e.phase == 'X') {
+            out << ",\"dur\":" << QString::number(e.duration / 1000.0, 'f', 3);
+        } else {
+            out << ",\"s\":\"t\"";
+        }
+        out << ",\"pid\":" << pid << ",\"tid\":1}";
+    }
+    out << "\n]}\n";
+    out.flush();
+
+    return file.flush();
+}
+
+} // namespace
@@ -0,0 +1,123 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2013 Pawel Bartkiewicz <tuuresairon@gmail.com>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+
+#ifndef KWIN_CROSSHAIR_TRACE_H
+#define KWIN_CROSSHAIR_TRACE_H
+
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QString>
+
+namespace KWin
+{
+
+/* Fixed-size ring buffer of trace events. Recording an event claims a slot
+ * with a single atomic increment and never allocates or locks; once the
+ * buffer is full the oldest events are overwritten. Event names must be
+ * string literals, only the pointer is stored. The buffer only exists while
+ * tracing is enabled. */
+class CrosshairTrace
+{
+public:
+
+    enum { CAPACITY = 4096 };
+
+    CrosshairTrace();
+    ~CrosshairTrace();
+
+    /* Enabling allocates an empty buffer, disabling drops the events */
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return m_events != NULL; }
+
+    /* Nanoseconds since the trace was created */
+    qint64 now() const { return m_clock.nsecsElapsed(); }
+
+    /* An event that took place between start and now() */
+    void complete(const char* name, qint64 start)
+    {
+        if (m_events != NULL) {
+            record(name, 'X', start, now() - start);
+        }
+    }
+
+    /* An event without duration */
+    void instant(const char* name)
+    {
+        if (m_events != NULL) {
+            record(name, 'i', now(), 0);
+        }
+    }
+
+    /* Writes the recorded events in the Chrome/Perfetto JSON trace format */
+    bool dump(const QString& fileName) const;
+
+private:
+
+    Q_DISABLE_COPY(CrosshairTrace)
+
+    struct Event
+    {
+        const char* name;
+        qint64 start;
+        qint64 duration;
+        char phase;
+    };
+
+    void record(const char* name, char phase, qint64 start, qint64 duration)
+    {
+        Event& e = m_events[static_cast<uint>(m_next.fetchAndAddRelaxed(1)) % CAPACITY];
+        e.name     = name;
+        e.phase    = phase;
+        e.start    = start;
+        e.duration = duration;
+    }
+
+    Event* m_events;
+    QAtomicInt m_next;
+    QElapsedTimer m_clock;
+};
+
+/* Records a complete event spanning the lifetime of the scope */
+class CrosshairTraceScope
+{
+public:
+
+    CrosshairTraceScope(CrosshairTrace& trace, const char* name)
+        : m_trace(trace)
+        , m_name(name)
+        , m_start(trace.isEnabled() ? trace.now() : 0)
+    {
+    }
+
+    ~CrosshairTraceScope()
+    {
+        m_trace.complete(m_name, m_start);
+    }
+
+private:
+
+    CrosshairTrace& m_trace;
+    const char* m_name;
+    qint64 m_start;
+};
+
+} // namespace
+
+#endif
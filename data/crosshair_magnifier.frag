@@ -0,0 +1,14 @@
+uniform sampler2D sampler;
+uniform vec2 center;
+uniform float radius;
+
+varying vec2 varyingTexCoords;
+
+void main()
+{
+    // Round inset, coordinates are in texture space
+    if (distance(varyingTexCoords, center) > radius)
+        discard;
+
+    gl_FragColor = texture2D(sampler, varyingTexCoords);
+}
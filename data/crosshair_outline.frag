@@ -0,0 +1,25 @@
+uniform vec4 lineColor;
+uniform vec4 outlineColor;
+uniform float coreWidth;
+
+varying vec2 varyingTexCoords;
+
+// Core quads have x shifted by this much, see CrosshairEffect::createOutline()
+const float CORE_PASS = 4.0;
+
+void main()
+{
+    vec2 t = varyingTexCoords;
+    if (t.x > CORE_PASS / 2.0) {
+        gl_FragColor = lineColor;
+        return;
+    }
+
+    // x runs across the stroke, y along it. The outline quad leaves the core
+    // (|x| <= coreWidth, 0 <= y <= 1) to the core quad, so with blend modes
+    // like invert no pixel is blended twice.
+    if (abs(t.x) <= coreWidth && t.y >= 0.0 && t.y <= 1.0) {
+        discard;
+    }
+    gl_FragColor = outlineColor;
+}
@@ -0,0 +1,10 @@
+uniform sampler2D sampler;
+uniform vec4 tint;
+
+varying vec2 varyingTexCoords;
+
+void main()
+{
+    // Single-channel coverage, coloured here instead of in the texture
+    gl_FragColor = tint * texture2D(sampler, varyingTexCoords).a;
+}
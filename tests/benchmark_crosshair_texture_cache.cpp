@@ -0,0 +1,125 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2013 Pawel Bartkiewicz <tuuresairon@gmail.com>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+
+#include "crosshair_texture_cache.h"
+
+#include <ktempdir.h>
+#include <qtest_kde.h>
+
+#include <QBuffer>
+#include <qmath.h>
+
+using namespace KWin;
+
+// Width and height of the generated crosshair image
+static const int SOURCE_SIZE = 1024;
+
+/* Compares the two ways loadTexture() gets a crosshair image ready for
+ * uploading: decoding, premultiplying and scaling the image file, and
+ * mapping the cached result. Each iteration ends with a copy of the pixels,
+ * as uploading does, so the cached path pays for faulting the mapping in. */
+class CrosshairTextureCacheBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void decode_data();
+    void decode();
+    void cached_data();
+    void cached();
+
+private:
+    void addSizeColumn();
+
+    QByteArray m_png;
+    KTempDir m_dir;
+};
+
+void CrosshairTextureCacheBenchmark::initTestCase()
+{
+    // A white ring with soft edges, like the images the effect tints
+    QImage image(SOURCE_SIZE, SOURCE_SIZE, QImage::Format_ARGB32);
+    const float centre = SOURCE_SIZE / 2.0f;
+    for (int y = 0; y < SOURCE_SIZE; ++y) {
+        QRgb* line = reinterpret_cast<QRgb*>(image.scanLine(y));
+        for (int x = 0; x < SOURCE_SIZE; ++x) {
+            const float distance = qAbs(qSqrt((x - centre) * (x - centre) + (y - centre) * (y - centre))
+                                        - SOURCE_SIZE / 4.0f);
+            const int alpha = qBound(0, int(255 * (1.0f - distance / 16.0f)), 255);
+            line[x] = qRgba(255, 255, 255, alpha);
+        }
+    }
+
+    QBuffer buffer(&m_png);
+    buffer.open(QIODevice::WriteOnly);
+    QVERIFY(image.save(&buffer, "PNG"));
+    QVERIFY(m_dir.exists());
+}
+
+void CrosshairTextureCacheBenchmark::addSizeColumn()
+{
+    // Rendered sizes, twice the Size setting
+    QTest::addColumn<int>("size");
+    QTest::newRow("64") << 64;
+    QTest::newRow("256") << 256;
+    QTest::newRow("1024") << 1024;
+}
+
+void CrosshairTextureCacheBenchmark::decode_data()
+{
+    addSizeColumn();
+}
+
+void CrosshairTextureCacheBenchmark::decode()
+{
+    QFETCH(int, size);
+
+    QBENCHMARK {
+        const QImage image = CrosshairTextureCache::decode(m_png, size).copy();
+        QCOMPARE(image.width(), size);
+    }
+}
+
+void CrosshairTextureCacheBenchmark::cached_data()
+{
+    addSizeColumn();
+}
+
+void CrosshairTextureCacheBenchmark::cached()
+{
+    QFETCH(int, size);
+
+    const QString path = m_dir.name() + CrosshairTextureCache::key(m_png, size);
+    {
+        CrosshairTextureCache cache(path);
+        QVERIFY(cache.store(CrosshairTextureCache::decode(m_png, size)));
+    }
+
+    QBENCHMARK {
+        CrosshairTextureCache cache(path);
+        const QImage image = cache.load(size).copy();
+        QCOMPARE(image.width(), size);
+    }
+}
+
+QTEST_KDEMAIN(CrosshairTextureCacheBenchmark, NoGUI)
+
+#include "benchmark_crosshair_texture_cache.moc"
@@ -0,0 +1,112 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2013 Pawel Bartkiewicz <tuuresairon@gmail.com>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+
+#include "crosshair_trace.h"
+
+#include <QtTest/QtTest>
+
+using namespace KWin;
+
+/* Measures what the tracer costs the paint path, with tracing off (the
+ * default) and on. Each iteration records what one frame records: two
+ * scopes and a repaint request. */
+class CrosshairTraceBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void instant_data();
+    void instant();
+    void scope_data();
+    void scope();
+    void frame_data();
+    void frame();
+
+private:
+    void addEnabledColumn();
+};
+
+void CrosshairTraceBenchmark::addEnabledColumn()
+{
+    QTest::addColumn<bool>("enabled");
+    QTest::newRow("off") << false;
+    QTest::newRow("on") << true;
+}
+
+void CrosshairTraceBenchmark::instant_data()
+{
+    addEnabledColumn();
+}
+
+void CrosshairTraceBenchmark::instant()
+{
+    QFETCH(bool, enabled);
+
+    CrosshairTrace trace;
+    trace.setEnabled(enabled);
+
+    QBENCHMARK {
+        trace.instant("addRepaint");
+    }
+}
+
+void CrosshairTraceBenchmark::scope_data()
+{
+    addEnabledColumn();
+}
+
+void CrosshairTraceBenchmark::scope()
+{
+    QFETCH(bool, enabled);
+
+    CrosshairTrace trace;
+    trace.setEnabled(enabled);
+
+    QBENCHMARK {
+        CrosshairTraceScope scope(trace, "paintScreen");
+    }
+}
+
+void CrosshairTraceBenchmark::frame_data()
+{
+    addEnabledColumn();
+}
+
+void CrosshairTraceBenchmark::frame()
+{
+    QFETCH(bool, enabled);
+
+    CrosshairTrace trace;
+    trace.setEnabled(enabled);
+
+    QBENCHMARK {
+        {
+            CrosshairTraceScope scope(trace, "prePaintScreen");
+        }
+        {
+            CrosshairTraceScope scope(trace, "paintScreen");
+        }
+        trace.instant("addRepaint");
+    }
+}
+
+QTEST_MAIN(CrosshairTraceBenchmark)
+
+#include "benchmark_crosshair_trace.moc"
@@ -0,0 +1,201 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2013 Pawel Bartkiewicz <tuuresairon@gmail.com>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+
+/* Example client of the external control feed, and a benchmark of its
+ * latency. It moves the crosshair in a circle and, one interval after each
+ * update, asks the effect over D-Bus when prePaintScreen picked it up. The
+ * single query per update is made while the client is otherwise idle, so it
+ * doesn't compete with the painting it measures. Updates not picked up
+ * within the interval count as missed.
+ *
+ * Usage: crosshair_feed_client [--count N] [--interval MS] [--centre X,Y]
+ *
+ * Needs a running KWin with "Allow External Control" enabled and the
+ * crosshair shown. */
+
+#include "crosshair_feed_protocol.h"
+
+#include <kcomponentdata.h>
+#include <kstandarddirs.h>
+
+#include <QCoreApplication>
+#include <QDBusInterface>
+#include <QDBusReply>
+#include <QLocalSocket>
+#include <QStringList>
+#include <QVector>
+#include <QtAlgorithms>
+#include <qmath.h>
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+// Updates per revolution of the circle
+static const int CIRCLE_STEPS = 50;
+static const float CIRCLE_RADIUS = 50.0f;
+
+static qint64 monotonicTime()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return qint64(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+/* Follows steps 1 and 2 of crosshair_feed_protocol.h. The socket has to
+ * stay connected for as long as the slot is used. */
+static CrosshairFeedSlot* connectFeed(QLocalSocket& socket)
+{
+    const QString path = KStandardDirs::locateLocal("socket", CROSSHAIR_FEED_SOCKET);
+    socket.connectToServer(path);
+    if (!socket.waitForConnected(1000)) {
+        fprintf(stderr, "Cannot connect to %s, is external control enabled?\n", qPrintable(path));
+        return NULL;
+    }
+
+    while (!socket.canReadLine()) {
+        if (!socket.waitForReadyRead(1000)) {
+            fprintf(stderr, "No greeting from the effect\n");
+            return NULL;
+        }
+    }
+
+    const QString line = QString::fromLocal8Bit(socket.readLine()).trimmed();
+    if (line == CROSSHAIR_FEED_BUSY) {
+        fprintf(stderr, "Another client is already controlling the crosshair\n");
+        return NULL;
+    }
+    const QStringList greeting = line.split(' ');
+    if (greeting.size() != 3 || greeting[0] != "KWIN-CROSSHAIR-FEED"
+            || greeting[1].toUInt() != CROSSHAIR_FEED_VERSION) {
+        fprintf(stderr, "Unsupported greeting: %s\n", qPrintable(greeting.join(" ")));
+        return NULL;
+    }
+
+    const QByteArray name = greeting[2].toLocal8Bit();
+    int fd = shm_open(name.constData(), O_RDWR, 0);
+    if (fd == -1) {
+        fprintf(stderr, "Cannot open shared memory %s\n", name.constData());
+        return NULL;
+    }
+    void* memory = mmap(NULL, sizeof(CrosshairFeedSlot), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) {
+        fprintf(stderr, "Cannot map shared memory %s\n", name.constData());
+        return NULL;
+    }
+
+    CrosshairFeedSlot* slot = static_cast<CrosshairFeedSlot*>(memory);
+    if (slot->magic != CROSSHAIR_FEED_MAGIC || slot->version != CROSSHAIR_FEED_VERSION) {
+        fprintf(stderr, "Shared memory %s is not a crosshair feed\n", name.constData());
+        munmap(memory, sizeof(CrosshairFeedSlot));
+        return NULL;
+    }
+    return slot;
+}
+
+static double percentile(const QVector<qint64>& sorted, int percent)
+{
+    return sorted[(sorted.size() - 1) * percent / 100] / 1000000.0;
+}
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+    KComponentData componentData("crosshair_feed_client");
+
+    int count = 200;
+    int interval = 50;
+    float centreX = 400.0f;
+    float centreY = 300.0f;
+
+    const QStringList args = app.arguments();
+    for (int i = 1; i + 1 < args.size(); i += 2) {
+        if (args[i] == "--count") {
+            count = qMax(1, args[i + 1].toInt());
+        } else if (args[i] == "--interval") {
+            interval = qMax(1, args[i + 1].toInt());
+        } else if (args[i] == "--centre") {
+            const QStringList centre = args[i + 1].split(',');
+            if (centre.size() == 2) {
+                centreX = centre[0].toFloat();
+                centreY = centre[1].toFloat();
+            }
+        } else {
+            fprintf(stderr, "Usage: %s [--count N] [--interval MS] [--centre X,Y]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    QLocalSocket socket;
+    CrosshairFeedSlot* slot = connectFeed(socket);
+    if (slot == NULL) {
+        return 1;
+    }
+
+    QDBusInterface effect("org.kde.kwin", "/Crosshair", "org.kde.kwin.Crosshair");
+    if (!effect.isValid()) {
+        fprintf(stderr, "The effect isn't on D-Bus, updates are written but not timed\n");
+    }
+
+    QVector<qint64> latencies;
+    int missed = 0;
+    for (int i = 0; i < count; ++i) {
+        const float angle = 2 * M_PI * (i % CIRCLE_STEPS) / CIRCLE_STEPS;
+
+        const qint64 written = monotonicTime();
+        crosshair_feed_write(slot, CROSSHAIR_FEED_POSITION,
+                             centreX + CIRCLE_RADIUS * qCos(angle),
+                             centreY + CIRCLE_RADIUS * qSin(angle), 0, 0);
+        const uint sequence = slot->sequence;
+
+        usleep(interval * 1000);
+
+        // The effect recorded when it read this update, nothing newer has
+        // been written since
+        if (effect.isValid()) {
+            const QDBusReply<qlonglong> reply = effect.call("feedPickupTime", sequence);
+            if (reply.isValid() && reply.value() >= 0) {
+                latencies.append(reply.value() - written);
+            } else {
+                ++missed;
+            }
+        }
+    }
+
+    munmap(slot, sizeof(CrosshairFeedSlot));
+
+    if (!effect.isValid()) {
+        return 0;
+    }
+    if (latencies.isEmpty()) {
+        fprintf(stderr, "No update was picked up, is the crosshair shown?\n");
+        return 1;
+    }
+
+    qSort(latencies);
+    printf("write -> prePaintScreen over %d updates (%d missed):\n", latencies.size(), missed);
+    printf("  min %.3f ms, median %.3f ms, 95%% %.3f ms, max %.3f ms\n",
+           percentile(latencies, 0), percentile(latencies, 50),
+           percentile(latencies, 95), percentile(latencies, 100));
+    return 0;
+}
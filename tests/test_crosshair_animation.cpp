@@ -0,0 +1,209 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2013 Pawel Bartkiewicz <tuuresairon@gmail.com>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+
+#include "crosshair_animation.h"
+
+#include <QtTest/QtTest>
+
+using namespace KWin;
+
+// Frame time passed to prePaintScreen (ms)
+static const int FRAME_TIME = 16;
+
+/* Paints frames for as long as postPaintScreen asks for them, making the
+ * calls CrosshairEffect makes. Returns the number of frames asked for;
+ * fadedOut is set when the crosshair would have been hidden. */
+static int paintFrames(CrosshairAnimation& animation, bool* fadedOut = 0)
+{
+    int repaints = 0;
+    for (int frame = 0; frame < 1000; ++frame) {
+        if (animation.prePaint(FRAME_TIME) == CrosshairAnimation::FadedOut && fadedOut != 0) {
+            *fadedOut = true;
+        }
+        if (!animation.needsRepaint()) {
+            break;
+        }
+        ++repaints;
+    }
+    return repaints;
+}
+
+/* Frames asked for by postPaintScreen while a duration ms animation runs,
+ * after the one that started it. The frame in which the timeline reaches
+ * its end is painted, but asks for no further frame. */
+static int expectedRepaints(int duration)
+{
+    return (duration + FRAME_TIME - 1) / FRAME_TIME - 1;
+}
+
+class CrosshairAnimationTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+    void idle();
+    void pulse_data();
+    void pulse();
+    void recoil();
+    void disabled();
+    void fadeIn();
+    void fadeOut();
+    void reverseFade();
+    void reset();
+
+private:
+    CrosshairAnimation* m_animation;
+};
+
+void CrosshairAnimationTest::init()
+{
+    m_animation = new CrosshairAnimation;
+    m_animation->setFade(200);
+    m_animation->setPulse(300, 0.5f);
+    m_animation->setRecoil(200, 10);
+    m_animation->reset();
+}
+
+void CrosshairAnimationTest::cleanup()
+{
+    delete m_animation;
+    m_animation = 0;
+}
+
+void CrosshairAnimationTest::idle()
+{
+    QVERIFY(!m_animation->needsRepaint());
+    QCOMPARE(m_animation->prePaint(FRAME_TIME), CrosshairAnimation::Unchanged);
+    QCOMPARE(paintFrames(*m_animation), 0);
+    QCOMPARE(m_animation->scale(), 1.0f);
+    QCOMPARE(m_animation->spread(), 0.0f);
+}
+
+void CrosshairAnimationTest::pulse_data()
+{
+    QTest::addColumn<int>("duration");
+    QTest::newRow("ends within a frame") << 300;
+    QTest::newRow("ends on a frame") << 20 * FRAME_TIME;
+    QTest::newRow("shorter than a frame") << 5;
+}
+
+void CrosshairAnimationTest::pulse()
+{
+    QFETCH(int, duration);
+    m_animation->setPulse(duration, 0.5f);
+
+    QVERIFY(m_animation->pulse());
+    QVERIFY(m_animation->isAnimating());
+
+    QCOMPARE(paintFrames(*m_animation), expectedRepaints(duration));
+
+    // Nothing more once the timeline has ended
+    QVERIFY(!m_animation->isAnimating());
+    QCOMPARE(paintFrames(*m_animation), 0);
+    QCOMPARE(m_animation->scale(), 1.0f);
+}
+
+void CrosshairAnimationTest::recoil()
+{
+    QVERIFY(m_animation->recoil());
+    QCOMPARE(m_animation->spread(), 10.0f);
+
+    QCOMPARE(paintFrames(*m_animation), expectedRepaints(200));
+    QVERIFY(!m_animation->isAnimating());
+    QCOMPARE(paintFrames(*m_animation), 0);
+    QCOMPARE(m_animation->spread(), 0.0f);
+}
+
+void CrosshairAnimationTest::disabled()
+{
+    m_animation->setFade(0);
+    m_animation->setPulse(0, 0.5f);
+    m_animation->setRecoil(0, 10);
+
+    QVERIFY(!m_animation->hasFade());
+    QVERIFY(!m_animation->pulse());
+    QVERIFY(!m_animation->recoil());
+    QVERIFY(!m_animation->isAnimating());
+    QCOMPARE(m_animation->opacity(), 1.0f);
+}
+
+void CrosshairAnimationTest::fadeIn()
+{
+    QVERIFY(m_animation->hasFade());
+    QCOMPARE(m_animation->opacity(), 0.0f);
+
+    m_animation->fadeIn();
+    bool fadedOut = false;
+    QCOMPARE(paintFrames(*m_animation, &fadedOut), expectedRepaints(200));
+
+    QVERIFY(!fadedOut);
+    QVERIFY(!m_animation->isAnimating());
+    QCOMPARE(m_animation->opacity(), 1.0f);
+}
+
+void CrosshairAnimationTest::fadeOut()
+{
+    m_animation->fadeIn();
+    paintFrames(*m_animation);
+
+    m_animation->reverseFade();
+    bool fadedOut = false;
+    QCOMPARE(paintFrames(*m_animation, &fadedOut), expectedRepaints(200));
+
+    QVERIFY(fadedOut);
+    QVERIFY(!m_animation->isAnimating());
+    QCOMPARE(m_animation->opacity(), 0.0f);
+}
+
+void CrosshairAnimationTest::reverseFade()
+{
+    // Toggled again halfway through fading in, it fades out from there
+    m_animation->fadeIn();
+    QCOMPARE(m_animation->prePaint(5 * FRAME_TIME), CrosshairAnimation::Changed);
+    const float opacity = m_animation->opacity();
+    QVERIFY(opacity > 0.0f && opacity < 1.0f);
+
+    m_animation->reverseFade();
+    bool fadedOut = false;
+    QCOMPARE(paintFrames(*m_animation, &fadedOut), expectedRepaints(5 * FRAME_TIME));
+    QVERIFY(fadedOut);
+    QCOMPARE(m_animation->opacity(), 0.0f);
+}
+
+void CrosshairAnimationTest::reset()
+{
+    m_animation->fadeIn();
+    m_animation->pulse();
+    m_animation->recoil();
+    m_animation->prePaint(FRAME_TIME);
+
+    m_animation->reset();
+    QVERIFY(!m_animation->isAnimating());
+    QCOMPARE(paintFrames(*m_animation), 0);
+    QCOMPARE(m_animation->opacity(), 0.0f);
+    QCOMPARE(m_animation->scale(), 1.0f);
+    QCOMPARE(m_animation->spread(), 0.0f);
+}
+
+QTEST_MAIN(CrosshairAnimationTest)
+
+#include "test_crosshair_animation.moc"